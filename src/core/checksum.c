@@ -0,0 +1,42 @@
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "checksum.h"
+
+// External assembly function
+extern uint32_t crc32c_sse42_asm(uint32_t crc, const uint8_t* data, size_t size);
+
+#define CRC32C_POLY 0x82F63B78u    // Castagnoli, bit-reversed
+
+// The fallback table and the CPU check are set up on first use
+static uint32_t g_crc32c_table[256];
+static bool g_crc32c_ready = false;
+static bool g_crc32c_hardware = false;
+
+static void init_crc32c(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? CRC32C_POLY ^ (c >> 1) : c >> 1;
+        }
+        g_crc32c_table[i] = c;
+    }
+    g_crc32c_hardware = SDL_HasSSE42();
+    g_crc32c_ready = true;
+}
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t size) {
+    if (!g_crc32c_ready) init_crc32c();
+
+    const uint8_t* bytes = (const uint8_t*)data;
+    crc = ~crc;
+    if (g_crc32c_hardware) {
+        crc = crc32c_sse42_asm(crc, bytes, size);
+    } else {
+        for (size_t i = 0; i < size; i++) {
+            crc = g_crc32c_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+        }
+    }
+    return ~crc;
+}
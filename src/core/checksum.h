@@ -0,0 +1,15 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC32C (Castagnoli polynomial), the checksum protecting save chunks.
+// Computed with the SSE4.2 crc32 instruction where the CPU has it and a
+// lookup table otherwise; both give identical results.
+//
+// Pass 0 to start a checksum, or a previous result to continue it over
+// more data.
+uint32_t crc32c(uint32_t crc, const void* data, size_t size);
+
+#endif // CHECKSUM_H
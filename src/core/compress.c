@@ -0,0 +1,217 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "compress.h"
+
+// Block format: a sequence is
+//   token (u8: literal count << 4 | (match length - MIN_MATCH))
+//   [literal count extension] literals offset (u16 LE) [match length extension]
+// A nibble of 15 is extended by bytes that are added on, stopping after the
+// first byte below 255. The last sequence is literals only.
+
+#define HASH_BITS 12
+#define MIN_MATCH 4
+#define LAST_LITERALS 5         // Matches stop this far from the end
+#define MATCH_SEARCH_END 12     // No match starts this close to the end
+#define MAX_OFFSET 65535
+#define SKIP_TRIGGER 6          // Step faster through data that will not compress
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Index of the lowest set bit of a nonzero value
+static inline unsigned lowest_set_bit(uint64_t value) {
+    #if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(value);
+    #elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (unsigned)index;
+    #else
+    unsigned index = 0;
+    while (!(value & 1)) {
+        value >>= 1;
+        index++;
+    }
+    return index;
+    #endif
+}
+
+static inline uint32_t hash4(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+size_t compress_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+static uint8_t* write_length(uint8_t* op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+static uint8_t* write_literals(uint8_t* op, const uint8_t* literals, size_t count, size_t match_nibble) {
+    *op++ = (uint8_t)(((count >= 15 ? 15 : count) << 4) | match_nibble);
+    if (count >= 15) op = write_length(op, count - 15);
+    memcpy(op, literals, count);
+    return op + count;
+}
+
+size_t compress_block(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    if (capacity < compress_bound(size)) return 0;
+
+    // Last position each 4-byte hash was seen at; stale or colliding entries
+    // are weeded out by comparing the bytes
+    uint32_t table[1 << HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;        // Start of pending literals
+    const uint8_t* end = src + size;
+    uint8_t* op = dst;
+
+    if (size > MATCH_SEARCH_END) {
+        const uint8_t* search_end = end - MATCH_SEARCH_END;
+        const uint8_t* match_end = end - LAST_LITERALS;
+        uint32_t misses = 0;
+
+        while (ip <= search_end) {
+            uint32_t sequence = read32(ip);
+            uint32_t h = hash4(sequence);
+            const uint8_t* ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+
+            if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != sequence) {
+                ip += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+
+            // Grow the match backwards into the pending literals, then forwards
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t* match = ip + MIN_MATCH;
+            const uint8_t* from = ref + MIN_MATCH;
+            size_t match_length;
+            while (match + 8 <= match_end) {
+                uint64_t diff = read64(match) ^ read64(from);
+                if (diff) {
+                    match += lowest_set_bit(diff) >> 3;   // Little-endian: first differing byte
+                    goto extended;
+                }
+                match += 8;
+                from += 8;
+            }
+            while (match < match_end && *match == *from) {
+                match++;
+                from++;
+            }
+        extended:
+            match_length = (size_t)(match - ip) - MIN_MATCH;
+            op = write_literals(op, anchor, (size_t)(ip - anchor), match_length >= 15 ? 15 : match_length);
+
+            size_t offset = (size_t)(ip - ref);
+            *op++ = (uint8_t)offset;
+            *op++ = (uint8_t)(offset >> 8);
+            if (match_length >= 15) op = write_length(op, match_length - 15);
+
+            anchor = ip = match;
+        }
+    }
+
+    op = write_literals(op, anchor, (size_t)(end - anchor), 0);
+    return (size_t)(op - dst);
+}
+
+// Read a nibble's extension bytes; false if the input runs out
+static bool read_length(const uint8_t** ip, const uint8_t* end, size_t* length) {
+    uint8_t byte;
+    do {
+        if (*ip >= end) return false;
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool decompress_block(const uint8_t* src, size_t size, uint8_t* dst, size_t out_size) {
+    const uint8_t* ip = src;
+    const uint8_t* end = src + size;
+    uint8_t* op = dst;
+    uint8_t* out_end = dst + out_size;
+
+    while (ip < end) {
+        uint8_t token = *ip++;
+
+        size_t literals = token >> 4;
+        size_t length = token & 15;
+
+        // Common case: short literals and a short match that does not overlap
+        // itself, well inside both buffers. Copy with fixed-size moves; the
+        // bytes written past the sequence are overwritten by the next one.
+        if (literals < 15 && length < 15 && end - ip >= 32 && out_end - op >= 32) {
+            size_t offset = (size_t)ip[literals] | ((size_t)ip[literals + 1] << 8);
+            if (offset >= 16 && offset <= (size_t)(op - dst) + literals) {
+                memcpy(op, ip, 16);
+                op += literals;
+                ip += literals + 2;
+
+                const uint8_t* ref = op - offset;
+                memcpy(op, ref, 16);
+                memcpy(op + 16, ref + 16, 2);   // Match length is at most 18
+                op += length + MIN_MATCH;
+                continue;
+            }
+        }
+
+        if (literals == 15 && !read_length(&ip, end, &literals)) return false;
+        if (literals > (size_t)(end - ip) || literals > (size_t)(out_end - op)) return false;
+        memcpy(op, ip, literals);
+        op += literals;
+        ip += literals;
+
+        if (ip == end) break;   // Final, literal-only sequence
+
+        if (end - ip < 2) return false;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return false;
+
+        if (length == 15 && !read_length(&ip, end, &length)) return false;
+        length += MIN_MATCH;
+        if (length > (size_t)(out_end - op)) return false;
+
+        // An offset shorter than the match repeats the last offset bytes; copy
+        // in growing steps that never overlap their source
+        const uint8_t* ref = op - offset;
+        size_t span = offset;
+        while (length > 0) {
+            size_t count = span < length ? span : length;
+            memcpy(op, ref, count);
+            op += count;
+            length -= count;
+            span += count;
+        }
+    }
+
+    return op == out_end;
+}
@@ -0,0 +1,24 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Small LZ77 block compressor in the LZ4 mould: byte-aligned sequences of
+// (token, literals, 16-bit offset, match length), no entropy coding. It
+// favours speed over ratio, which suits save data: long runs of zeros and
+// repeated records compress well and decompression is close to memcpy speed.
+
+// Largest output compress_block can produce for size input bytes
+size_t compress_bound(size_t size);
+
+// Compress into dst, which must hold compress_bound(size) bytes.
+// Returns the compressed size.
+size_t compress_block(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+
+// Decompress exactly out_size bytes. Every length and offset is checked, so
+// corrupt input fails instead of reading or writing out of bounds.
+bool decompress_block(const uint8_t* src, size_t size, uint8_t* dst, size_t out_size);
+
+#endif // COMPRESS_H
@@ -0,0 +1,65 @@
+; CRC32C kernel for save file checksums
+; Optimized for x86-64 (SSE4.2)
+
+section .text
+    global crc32c_sse42_asm
+
+; Continue a CRC32C over a run of bytes
+; uint32_t crc32c_sse42_asm(uint32_t crc, const uint8_t* data, size_t size)
+; Arguments: edi=crc, rsi=data, rdx=size
+; Works on the inverted running value; the caller inverts before and after
+crc32c_sse42_asm:
+    mov eax, edi
+    test rdx, rdx
+    jz .done
+
+    ; Single bytes until data is 8-byte aligned
+.align_loop:
+    test rsi, 7
+    jz .aligned
+    crc32 eax, byte [rsi]
+    inc rsi
+    dec rdx
+    jz .done
+    jmp .align_loop
+
+.aligned:
+    ; 32 bytes per iteration. Each crc32 depends on the previous one, so the
+    ; unrolling only saves loop overhead.
+    mov rcx, rdx
+    shr rcx, 5
+    jz .qwords
+
+.loop32:
+    crc32 rax, qword [rsi]
+    crc32 rax, qword [rsi + 8]
+    crc32 rax, qword [rsi + 16]
+    crc32 rax, qword [rsi + 24]
+    add rsi, 32
+    dec rcx
+    jnz .loop32
+
+.qwords:
+    mov rcx, rdx
+    shr rcx, 3
+    and rcx, 3
+    jz .tail
+
+.loop8:
+    crc32 rax, qword [rsi]
+    add rsi, 8
+    dec rcx
+    jnz .loop8
+
+.tail:
+    and rdx, 7
+    jz .done
+
+.loop1:
+    crc32 eax, byte [rsi]
+    inc rsi
+    dec rdx
+    jnz .loop1
+
+.done:
+    ret
@@ -1,6 +1,16 @@
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "render_target.h"
+
+#define GLYPH_SIZE 8
+#define MAX_GLYPH_RUNS 32       // 8 rows x at most 4 runs of set bits
+#define MIN_SIMD_RUN 4          // Shorter runs are cheaper as plain stores
+
+// External assembly functions
+extern void fill_span_asm(uint8_t* dest, int count, uint32_t color);
+
 // Simple 8x8 bitmap font
 // Each character is 8 bytes, each byte represents a row of 8 pixels
 static const uint8_t font_data[128][8] = {
@@ -178,37 +188,121 @@ static const uint8_t font_data[128][8] = {
     [127] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
 };
 
-void draw_char_bitmap(uint8_t* framebuffer, int x, int y, char c, 
-                      uint32_t color, int screen_width) {
-    if (c < 0 || c > 127) c = '?';
-    
-    const uint8_t* glyph = font_data[(int)c];
-    
-    for (int row = 0; row < 8; row++) {
-        uint8_t row_data = glyph[row];
-        for (int col = 0; col < 8; col++) {
-            if (row_data & (0x80 >> col)) {
-                int px = x + col;
-                int py = y + row;
-                
-                if (px >= 0 && px < screen_width && py >= 0 && py < 600) {
-                    int idx = (py * screen_width + px) * 4;
-                    framebuffer[idx + 0] = (color >> 0) & 0xFF;  // B
-                    framebuffer[idx + 1] = (color >> 8) & 0xFF;  // G
-                    framebuffer[idx + 2] = (color >> 16) & 0xFF; // R
-                    framebuffer[idx + 3] = 0xFF;                 // A
+// A horizontal run of set pixels within a glyph
+typedef struct {
+    uint8_t row;
+    uint8_t x;
+    uint8_t length;
+} GlyphRun;
+
+typedef struct {
+    int count;
+    GlyphRun runs[MAX_GLYPH_RUNS];
+} GlyphRuns;
+
+static GlyphRuns g_glyph_runs[128];
+static bool g_glyph_runs_ready = false;
+
+// Convert every glyph bitmap into row runs once
+static void build_glyph_runs(void) {
+    for (int c = 0; c < 128; c++) {
+        GlyphRuns* glyph = &g_glyph_runs[c];
+        glyph->count = 0;
+
+        for (int row = 0; row < GLYPH_SIZE; row++) {
+            uint8_t row_data = font_data[c][row];
+            int col = 0;
+            while (col < GLYPH_SIZE) {
+                if (!(row_data & (0x80 >> col))) {
+                    col++;
+                    continue;
                 }
+                int start = col;
+                while (col < GLYPH_SIZE && (row_data & (0x80 >> col))) col++;
+
+                GlyphRun* run = &glyph->runs[glyph->count++];
+                run->row = (uint8_t)row;
+                run->x = (uint8_t)start;
+                run->length = (uint8_t)(col - start);
             }
         }
     }
+    g_glyph_runs_ready = true;
 }
 
-void draw_text_bitmap(uint8_t* framebuffer, int x, int y, const char* text, 
-                      uint32_t color, int screen_width) {
-    int offset = 0;
-    while (*text) {
-        draw_char_bitmap(framebuffer, x + offset, y, *text, color, screen_width);
-        offset += 8;  // 8 pixels per character
-        text++;
+static inline void fill_run(uint32_t* dest, int length, uint32_t pixel) {
+    if (length >= MIN_SIMD_RUN) {
+        fill_span_asm((uint8_t*)dest, length, pixel);
+        return;
+    }
+    for (int i = 0; i < length; i++) {
+        dest[i] = pixel;
+    }
+}
+
+// Draw one glyph that lies entirely on the target; stride is in pixels
+static void draw_glyph_unclipped(uint32_t* origin, int c, uint32_t pixel, int stride) {
+    const GlyphRuns* glyph = &g_glyph_runs[c];
+    for (int i = 0; i < glyph->count; i++) {
+        const GlyphRun* run = &glyph->runs[i];
+        fill_run(origin + run->row * stride + run->x, run->length, pixel);
+    }
+}
+
+// Draw one glyph, clipping each run to the target
+static void draw_glyph_clipped(const RenderTarget* target, int x, int y, int c, uint32_t pixel) {
+    const GlyphRuns* glyph = &g_glyph_runs[c];
+    for (int i = 0; i < glyph->count; i++) {
+        const GlyphRun* run = &glyph->runs[i];
+        int py = y + run->row;
+        if (py < 0 || py >= target->height) continue;
+
+        int x0 = x + run->x;
+        int x1 = x0 + run->length;
+        if (x0 < 0) x0 = 0;
+        if (x1 > target->width) x1 = target->width;
+        if (x0 >= x1) continue;
+
+        fill_run((uint32_t*)render_target_pixel(target, x0, py), x1 - x0, pixel);
     }
-}
\ No newline at end of file
+}
+
+static int glyph_index(char c) {
+    if (c < 0 || c > 127) c = '?';
+    return (int)c;
+}
+
+void draw_char_bitmap(const RenderTarget* target, int x, int y, char c, uint32_t color) {
+    if (!g_glyph_runs_ready) build_glyph_runs();
+
+    draw_glyph_clipped(target, x, y, glyph_index(c), 0xFF000000 | color);
+}
+
+void draw_text_bitmap(const RenderTarget* target, int x, int y, const char* text, uint32_t color) {
+    if (!g_glyph_runs_ready) build_glyph_runs();
+
+    int length = 0;
+    while (text[length]) length++;
+
+    // Clip the whole string once
+    int text_width = length * GLYPH_SIZE;
+    if (length == 0 || y >= target->height || y + GLYPH_SIZE <= 0 ||
+        x >= target->width || x + text_width <= 0) {
+        return;
+    }
+
+    uint32_t pixel = 0xFF000000 | color;
+
+    if (x >= 0 && y >= 0 && x + text_width <= target->width && y + GLYPH_SIZE <= target->height) {
+        uint32_t* origin = (uint32_t*)render_target_pixel(target, x, y);
+        int stride = target->pitch / 4;
+        for (int i = 0; i < length; i++) {
+            draw_glyph_unclipped(origin + i * GLYPH_SIZE, glyph_index(text[i]), pixel, stride);
+        }
+        return;
+    }
+
+    for (int i = 0; i < length; i++) {
+        draw_glyph_clipped(target, x + i * GLYPH_SIZE, y, glyph_index(text[i]), pixel);
+    }
+}
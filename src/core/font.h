@@ -3,12 +3,12 @@
 
 #include <stdint.h>
 
-// Draw a single character using bitmap font
-void draw_char_bitmap(uint8_t* framebuffer, int x, int y, char c, 
-                      uint32_t color, int screen_width);
+#include "render_target.h"
 
-// Draw a text string using bitmap font
-void draw_text_bitmap(uint8_t* framebuffer, int x, int y, const char* text, 
-                      uint32_t color, int screen_width);
+// Draw a single character using bitmap font (clipped to the target)
+void draw_char_bitmap(const RenderTarget* target, int x, int y, char c, uint32_t color);
+
+// Draw a text string using bitmap font; the string is clipped once as a whole
+void draw_text_bitmap(const RenderTarget* target, int x, int y, const char* text, uint32_t color);
 
 #endif // FONT_H
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "headless.h"
+#include "image_io.h"
+#include "render_target.h"
+#include "random.h"
+#include "replay.h"
+
+// Forward declarations
+extern void init_renderer(const RenderTarget* target);
+extern void render_frame(void);
+extern void shutdown_particle_raster(void);
+extern bool init_sprite_system(void);
+extern void init_simulation(void);
+extern void update_simulation(float dt);
+extern void init_ui(void);
+extern void render_ui(void);
+extern void set_zoom_level(int zoom);
+extern void move_camera(int dx, int dy);
+extern bool load_game(int slot);
+
+#define HEADLESS_DEFAULT_FRAMES 60
+#define HEADLESS_DEFAULT_WIDTH 800
+#define HEADLESS_DEFAULT_HEIGHT 600
+#define HEADLESS_FRAME_DT (1.0f / 60.0f)    // Fixed step so runs are repeatable
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [--headless [options] | --bench-save]\n", program);
+    printf("  --headless         Render offscreen without opening a window\n");
+    printf("  --load SLOT        Load a saved park before rendering\n");
+    printf("  --replay SLOT      Re-run the commands recorded over a save, unrendered\n");
+    printf("  --frames N         Number of frames to render (default %d)\n", HEADLESS_DEFAULT_FRAMES);
+    printf("  --out DIR          Write frames to DIR (omit to only benchmark)\n");
+    printf("  --format FMT       png, ppm or raw (default png)\n");
+    printf("  --size WxH         Framebuffer size (default %dx%d)\n",
+           HEADLESS_DEFAULT_WIDTH, HEADLESS_DEFAULT_HEIGHT);
+    printf("  --camera X,Y       Scroll the camera by X,Y pixels\n");
+    printf("  --zoom N           Zoom level (0 = 1x)\n");
+    printf("  --seed N           Random seed (default 1)\n");
+    printf("  --bench-save       Time save/load with and without compression\n");
+}
+
+bool parse_headless_args(int argc, char* argv[], HeadlessOptions* options) {
+    memset(options, 0, sizeof(*options));
+    options->load_slot = -1;
+    options->replay_slot = -1;
+    options->frames = HEADLESS_DEFAULT_FRAMES;
+    options->format = FRAME_FORMAT_PNG;
+    options->width = HEADLESS_DEFAULT_WIDTH;
+    options->height = HEADLESS_DEFAULT_HEIGHT;
+    options->seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool ok = true;
+
+        if (strcmp(arg, "--headless") == 0) {
+            options->enabled = true;
+            continue;
+        } else if (strcmp(arg, "--bench-save") == 0) {
+            options->bench_save = true;
+            continue;
+        } else if (strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return false;
+        }
+
+        // Everything else takes a value
+        if (!value) {
+            ok = false;
+        } else if (strcmp(arg, "--load") == 0) {
+            ok = sscanf(value, "%d", &options->load_slot) == 1;
+        } else if (strcmp(arg, "--replay") == 0) {
+            ok = sscanf(value, "%d", &options->replay_slot) == 1 && options->replay_slot >= 0;
+            options->enabled = true;
+        } else if (strcmp(arg, "--frames") == 0) {
+            ok = sscanf(value, "%d", &options->frames) == 1 && options->frames > 0;
+        } else if (strcmp(arg, "--out") == 0) {
+            options->out_dir = value;
+        } else if (strcmp(arg, "--format") == 0) {
+            if (strcmp(value, "png") == 0) options->format = FRAME_FORMAT_PNG;
+            else if (strcmp(value, "ppm") == 0) options->format = FRAME_FORMAT_PPM;
+            else if (strcmp(value, "raw") == 0) options->format = FRAME_FORMAT_RAW;
+            else ok = false;
+        } else if (strcmp(arg, "--size") == 0) {
+            ok = sscanf(value, "%dx%d", &options->width, &options->height) == 2 &&
+                 options->width > 0 && options->height > 0;
+        } else if (strcmp(arg, "--camera") == 0) {
+            ok = sscanf(value, "%d,%d", &options->camera_x, &options->camera_y) == 2;
+        } else if (strcmp(arg, "--zoom") == 0) {
+            ok = sscanf(value, "%d", &options->zoom) == 1;
+        } else if (strcmp(arg, "--seed") == 0) {
+            ok = sscanf(value, "%u", &options->seed) == 1;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            printf("Bad argument: %s%s%s\n", arg, value ? " " : "", value ? value : "");
+            print_usage(argv[0]);
+            return false;
+        }
+        i++;
+    }
+
+    if (options->bench_save && options->enabled) {
+        printf("--bench-save cannot be combined with --headless or --replay\n");
+        print_usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+static bool write_frame(const HeadlessOptions* options, const RenderTarget* target,
+                        int frame, FILE* raw_file) {
+    char path[512];
+
+    switch (options->format) {
+        case FRAME_FORMAT_PNG:
+            snprintf(path, sizeof(path), "%s/frame_%05d.png", options->out_dir, frame);
+            return write_png(path, target);
+        case FRAME_FORMAT_PPM:
+            snprintf(path, sizeof(path), "%s/frame_%05d.ppm", options->out_dir, frame);
+            return write_ppm(path, target);
+        case FRAME_FORMAT_RAW:
+            if (!write_raw_frame(raw_file, target)) {
+                printf("Failed to write raw frame %d\n", frame);
+                return false;
+            }
+            return true;
+    }
+    return false;
+}
+
+bool run_headless(const HeadlessOptions* options) {
+    RenderTarget target;
+    target.width = options->width;
+    target.height = options->height;
+    target.pitch = options->width * 4;
+    target.pixels = (uint8_t*)calloc((size_t)target.pitch * target.height, 1);
+    if (!target.pixels) {
+        printf("Framebuffer allocation failed\n");
+        return false;
+    }
+
+    FILE* raw_file = NULL;
+    if (options->out_dir) {
+        #ifdef _WIN32
+        mkdir(options->out_dir);
+        #else
+        mkdir(options->out_dir, 0755);
+        #endif
+
+        if (options->format == FRAME_FORMAT_RAW) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/frames.raw", options->out_dir);
+            raw_file = fopen(path, "wb");
+            if (!raw_file) {
+                printf("Failed to open frame file: %s\n", path);
+                free(target.pixels);
+                return false;
+            }
+        }
+    }
+
+    // Same start-up order as the windowed game, minus SDL video
+    seed_game_rand(options->seed);
+    init_renderer(&target);
+    init_sprite_system();
+    init_simulation();
+    init_ui();
+
+    bool ok = true;
+    int frames = options->frames;
+    if (options->replay_slot >= 0) {
+        // The replay loads its own save and runs the simulation flat out
+        ok = run_replay(options->replay_slot);
+        frames = 0;
+    } else if (options->load_slot >= 0 && !load_game(options->load_slot)) {
+        ok = false;
+    }
+
+    set_zoom_level(options->zoom);
+    move_camera(options->camera_x, options->camera_y);
+
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    uint64_t total_ticks = 0;
+    uint64_t min_ticks = UINT64_MAX;
+    uint64_t max_ticks = 0;
+    int rendered = 0;
+
+    // The simulation runs on this thread, one fixed step per frame, so the
+    // same options always produce the same frames
+    for (int frame = 0; ok && frame < frames; frame++) {
+        update_simulation(HEADLESS_FRAME_DT);
+
+        uint64_t start = SDL_GetPerformanceCounter();
+        render_frame();
+        render_ui();
+        uint64_t ticks = SDL_GetPerformanceCounter() - start;
+
+        total_ticks += ticks;
+        if (ticks < min_ticks) min_ticks = ticks;
+        if (ticks > max_ticks) max_ticks = ticks;
+        rendered++;
+
+        if (options->out_dir && !write_frame(options, &target, frame, raw_file)) {
+            ok = false;
+        }
+    }
+
+    if (rendered > 0) {
+        double avg_ms = total_ticks * 1000.0 / frequency / rendered;
+        printf("Rendered %d frames at %dx%d: %.3f ms/frame (min %.3f, max %.3f), %.1f FPS\n",
+               rendered, target.width, target.height, avg_ms,
+               min_ticks * 1000.0 / frequency, max_ticks * 1000.0 / frequency,
+               avg_ms > 0.0 ? 1000.0 / avg_ms : 0.0);
+    }
+    if (raw_file) {
+        if (fclose(raw_file) != 0) ok = false;
+        if (ok) {
+            printf("Raw frames: %dx%d, 32-bit BGRA, %d bytes per frame\n",
+                   target.width, target.height, target.width * target.height * 4);
+        }
+    }
+
+    shutdown_particle_raster();
+    free(target.pixels);
+    return ok;
+}
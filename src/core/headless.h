@@ -0,0 +1,39 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdbool.h>
+
+// Render a park offscreen with no window: for pixel regression checks and
+// render benchmarks on machines without a display.
+
+typedef enum {
+    FRAME_FORMAT_PNG,
+    FRAME_FORMAT_PPM,
+    FRAME_FORMAT_RAW        // One file of tightly packed BGRA frames
+} FrameFormat;
+
+typedef struct {
+    bool enabled;
+    int load_slot;          // Save slot to load, or -1 for a fresh park
+    int replay_slot;        // Slot whose command journal to replay, or -1
+    int frames;
+    const char* out_dir;    // NULL to render without writing frames
+    FrameFormat format;
+    int width, height;
+    int camera_x, camera_y; // Offset applied with move_camera()
+    int zoom;
+    unsigned int seed;
+    bool bench_save;        // Run the save benchmark instead of the game
+} HeadlessOptions;
+
+// Fill options from the command line; returns false (after printing usage)
+// on a bad argument. options->enabled is set by --headless or --replay;
+// --bench-save may appear anywhere but not alongside either of them.
+bool parse_headless_args(int argc, char* argv[], HeadlessOptions* options);
+
+// Step the simulation at a fixed rate and render options->frames frames,
+// then print the render rate. With a replay slot, re-run that slot's
+// command journal flat out instead and print the simulation rate.
+bool run_headless(const HeadlessOptions* options);
+
+#endif // HEADLESS_H
@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "image_io.h"
+
+#define DEFLATE_MAX_STORED 65535    // Largest stored deflate block
+
+// Convert one row of 0xAARRGGBB pixels to packed RGB
+static void row_to_rgb(const RenderTarget* target, int y, uint8_t* out) {
+    const uint32_t* row = (const uint32_t*)render_target_pixel(target, 0, y);
+    for (int x = 0; x < target->width; x++) {
+        uint32_t pixel = row[x];
+        *out++ = (uint8_t)(pixel >> 16);
+        *out++ = (uint8_t)(pixel >> 8);
+        *out++ = (uint8_t)pixel;
+    }
+}
+
+bool write_ppm(const char* path, const RenderTarget* target) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        printf("Failed to open image file: %s\n", path);
+        return false;
+    }
+
+    uint8_t* rgb = (uint8_t*)malloc((size_t)target->width * 3);
+    if (!rgb) {
+        fclose(f);
+        return false;
+    }
+
+    fprintf(f, "P6\n%d %d\n255\n", target->width, target->height);
+    bool ok = true;
+    for (int y = 0; y < target->height && ok; y++) {
+        row_to_rgb(target, y, rgb);
+        ok = fwrite(rgb, 3, (size_t)target->width, f) == (size_t)target->width;
+    }
+
+    free(rgb);
+    if (fclose(f) != 0) ok = false;
+    if (!ok) printf("Failed to write image file: %s\n", path);
+    return ok;
+}
+
+bool write_raw_frame(FILE* f, const RenderTarget* target) {
+    size_t row_bytes = (size_t)target->width * 4;
+    for (int y = 0; y < target->height; y++) {
+        if (fwrite(render_target_pixel(target, 0, y), 1, row_bytes, f) != row_bytes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// PNG chunks are CRC-32 (IEEE) protected; the table is built on first use
+static uint32_t g_crc_table[256];
+static bool g_crc_table_ready = false;
+
+static void build_crc_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        g_crc_table[i] = c;
+    }
+    g_crc_table_ready = true;
+}
+
+// Writes bytes to the file while keeping the running chunk CRC and the
+// zlib Adler-32 of the image data
+typedef struct {
+    FILE* f;
+    uint32_t crc;
+    uint32_t adler_a, adler_b;
+    bool ok;
+} PngWriter;
+
+static void png_put(PngWriter* w, const uint8_t* data, size_t size) {
+    uint32_t crc = w->crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = g_crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    w->crc = crc;
+    if (fwrite(data, 1, size, w->f) != size) w->ok = false;
+}
+
+static void png_put_u32(PngWriter* w, uint32_t value) {
+    uint8_t bytes[4] = { (uint8_t)(value >> 24), (uint8_t)(value >> 16),
+                         (uint8_t)(value >> 8), (uint8_t)value };
+    png_put(w, bytes, 4);
+}
+
+static void png_begin_chunk(PngWriter* w, const char* type, uint32_t length) {
+    png_put_u32(w, length);     // Length is not covered by the CRC
+    w->crc = 0xFFFFFFFFu;
+    png_put(w, (const uint8_t*)type, 4);
+}
+
+static void png_end_chunk(PngWriter* w) {
+    png_put_u32(w, w->crc ^ 0xFFFFFFFFu);
+}
+
+static void png_put_image_data(PngWriter* w, const uint8_t* data, size_t size) {
+    // Adler-32 sums stay below 2^32 for 5552 bytes between reductions
+    uint32_t a = w->adler_a, b = w->adler_b;
+    for (size_t i = 0; i < size; ) {
+        size_t end = i + 5552 < size ? i + 5552 : size;
+        for (; i < end; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    w->adler_a = a;
+    w->adler_b = b;
+    png_put(w, data, size);
+}
+
+bool write_png(const char* path, const RenderTarget* target) {
+    if (target->width <= 0 || target->height <= 0) return false;
+    if (!g_crc_table_ready) build_crc_table();
+
+    // Filter byte (none) + RGB per scanline, split into stored blocks
+    size_t row_bytes = 1 + (size_t)target->width * 3;
+    size_t raw_size = row_bytes * target->height;
+    size_t num_blocks = (raw_size + DEFLATE_MAX_STORED - 1) / DEFLATE_MAX_STORED;
+    if (num_blocks == 0) num_blocks = 1;
+    size_t idat_size = 2 + raw_size + num_blocks * 5 + 4;
+    if (idat_size > 0x7FFFFFFFu) {
+        printf("Image too large for a single PNG chunk: %s\n", path);
+        return false;
+    }
+
+    uint8_t* row = (uint8_t*)malloc(row_bytes);
+    if (!row) return false;
+
+    PngWriter w = { fopen(path, "wb"), 0, 1, 0, true };
+    if (!w.f) {
+        printf("Failed to open image file: %s\n", path);
+        free(row);
+        return false;
+    }
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png_put(&w, signature, sizeof(signature));
+
+    png_begin_chunk(&w, "IHDR", 13);
+    png_put_u32(&w, (uint32_t)target->width);
+    png_put_u32(&w, (uint32_t)target->height);
+    static const uint8_t ihdr_tail[5] = { 8, 2, 0, 0, 0 };  // 8-bit RGB, no interlace
+    png_put(&w, ihdr_tail, sizeof(ihdr_tail));
+    png_end_chunk(&w);
+
+    png_begin_chunk(&w, "IDAT", (uint32_t)idat_size);
+    static const uint8_t zlib_header[2] = { 0x78, 0x01 };
+    png_put(&w, zlib_header, sizeof(zlib_header));
+
+    // Scanlines are produced one at a time and may straddle block boundaries
+    size_t remaining = raw_size;
+    size_t block_left = 0;
+    for (int y = 0; y < target->height; y++) {
+        row[0] = 0;
+        row_to_rgb(target, y, row + 1);
+
+        size_t offset = 0;
+        while (offset < row_bytes) {
+            if (block_left == 0) {
+                block_left = remaining < DEFLATE_MAX_STORED ? remaining : DEFLATE_MAX_STORED;
+                uint8_t block_header[5] = {
+                    (uint8_t)(block_left == remaining ? 1 : 0),  // BFINAL, BTYPE = stored
+                    (uint8_t)block_left, (uint8_t)(block_left >> 8),
+                    (uint8_t)~block_left, (uint8_t)(~block_left >> 8)
+                };
+                png_put(&w, block_header, sizeof(block_header));
+            }
+
+            size_t count = row_bytes - offset;
+            if (count > block_left) count = block_left;
+            png_put_image_data(&w, row + offset, count);
+            offset += count;
+            block_left -= count;
+            remaining -= count;
+        }
+    }
+
+    png_put_u32(&w, (w.adler_b << 16) | w.adler_a);
+    png_end_chunk(&w);
+
+    png_begin_chunk(&w, "IEND", 0);
+    png_end_chunk(&w);
+
+    free(row);
+    if (fclose(w.f) != 0) w.ok = false;
+    if (!w.ok) printf("Failed to write image file: %s\n", path);
+    return w.ok;
+}
@@ -0,0 +1,18 @@
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "render_target.h"
+
+// Write a render target as a 24-bit image; alpha is dropped.
+// The PNG writer uses stored (uncompressed) deflate blocks, so it needs no
+// zlib and its output is byte-for-byte reproducible.
+bool write_ppm(const char* path, const RenderTarget* target);
+bool write_png(const char* path, const RenderTarget* target);
+
+// Append the target's rows, tightly packed as 32-bit BGRA, to an open file
+bool write_raw_frame(FILE* f, const RenderTarget* target);
+
+#endif // IMAGE_IO_H
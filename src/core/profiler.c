@@ -0,0 +1,157 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "profiler.h"
+#include "font.h"
+
+// External assembly functions
+extern void fill_rect_asm(const RenderTarget* target, int x, int y, int width, int height, uint32_t color);
+
+#define PROFILE_MAX_SAMPLE_NS 0x7FFFFFFF
+#define OVERLAY_WIDTH 264
+#define OVERLAY_LINE_HEIGHT 10
+
+// Samples are written by the timing thread and read by the render thread,
+// so they go through SDL atomics rather than plain ints.
+typedef struct {
+    SDL_atomic_t samples[PROFILE_HISTORY];  // Nanoseconds
+    SDL_atomic_t head;                      // Next slot to write
+    SDL_atomic_t count;                     // Valid samples (<= PROFILE_HISTORY)
+} ZoneHistory;
+
+static const char* g_zone_names[PROF_ZONE_COUNT] = {
+    "sim",
+    " guests",
+    " rides",
+    " staff",
+    " litter",
+    " weather",
+    " snapshot",
+    "render",
+    " sky",
+    " terrain",
+    " objects",
+    " entities",
+    " lights",
+    " particles",
+    "ui",
+    "upload",
+};
+
+static ZoneHistory g_zones[PROF_ZONE_COUNT];
+static bool g_overlay_visible = false;
+
+uint64_t profile_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void profile_record(ProfileZone zone, uint64_t start) {
+    uint64_t elapsed = profile_now() - start;
+    if (elapsed > PROFILE_MAX_SAMPLE_NS) elapsed = PROFILE_MAX_SAMPLE_NS;
+
+    ZoneHistory* history = &g_zones[zone];
+    int head = SDL_AtomicGet(&history->head);
+    SDL_AtomicSet(&history->samples[head], (int)elapsed);
+    SDL_AtomicSet(&history->head, (head + 1) % PROFILE_HISTORY);
+
+    if (SDL_AtomicGet(&history->count) < PROFILE_HISTORY) {
+        SDL_AtomicAdd(&history->count, 1);
+    }
+}
+
+// Last, average and maximum sample of a zone in milliseconds
+static void get_zone_stats(ProfileZone zone, float* last, float* avg, float* max) {
+    ZoneHistory* history = &g_zones[zone];
+    int count = SDL_AtomicGet(&history->count);
+    int head = SDL_AtomicGet(&history->head);
+
+    *last = *avg = *max = 0.0f;
+    if (count == 0) return;
+
+    int64_t total = 0;
+    int peak = 0;
+    for (int i = 0; i < count; i++) {
+        int sample = SDL_AtomicGet(&history->samples[(head - 1 - i + PROFILE_HISTORY) % PROFILE_HISTORY]);
+        total += sample;
+        if (sample > peak) peak = sample;
+    }
+
+    *last = SDL_AtomicGet(&history->samples[(head - 1 + PROFILE_HISTORY) % PROFILE_HISTORY]) / 1000000.0f;
+    *avg = (float)(total / count) / 1000000.0f;
+    *max = peak / 1000000.0f;
+}
+
+void toggle_profiler_overlay(void) {
+    g_overlay_visible = !g_overlay_visible;
+    printf("Profiler overlay %s\n", g_overlay_visible ? "on" : "off");
+}
+
+void draw_profiler_overlay(const RenderTarget* target) {
+    if (!g_overlay_visible) return;
+
+    int height = (PROF_ZONE_COUNT + 1) * OVERLAY_LINE_HEIGHT + 8;
+    int x = target->width - OVERLAY_WIDTH - 10;
+    int y = 10;
+    if (x < 0 || y + height > target->height) return;
+
+    fill_rect_asm(target, x, y, OVERLAY_WIDTH, height, 0x202020);
+
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%-11s %6s %6s %6s", "ms", "last", "avg", "max");
+    draw_text_bitmap(target, x + 4, y + 4, buffer, 0xFFFF00);
+
+    for (int zone = 0; zone < PROF_ZONE_COUNT; zone++) {
+        float last, avg, max;
+        get_zone_stats((ProfileZone)zone, &last, &avg, &max);
+
+        snprintf(buffer, sizeof(buffer), "%-11s %6.2f %6.2f %6.2f",
+                 g_zone_names[zone], last, avg, max);
+        uint32_t color = (g_zone_names[zone][0] == ' ') ? 0xC0C0C0 : 0xFFFFFF;
+        draw_text_bitmap(target, x + 4, y + 4 + (zone + 1) * OVERLAY_LINE_HEIGHT, buffer, color);
+    }
+}
+
+// One row per history slot (oldest first), one column per zone, in milliseconds
+bool dump_profiler_csv(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        printf("Failed to open profile file: %s\n", path);
+        return false;
+    }
+
+    fprintf(f, "sample");
+    for (int zone = 0; zone < PROF_ZONE_COUNT; zone++) {
+        const char* name = g_zone_names[zone];
+        while (*name == ' ') name++;
+        fprintf(f, ",%s", name);
+    }
+    fprintf(f, "\n");
+
+    for (int row = 0; row < PROFILE_HISTORY; row++) {
+        fprintf(f, "%d", row);
+        for (int zone = 0; zone < PROF_ZONE_COUNT; zone++) {
+            ZoneHistory* history = &g_zones[zone];
+            int count = SDL_AtomicGet(&history->count);
+            int head = SDL_AtomicGet(&history->head);
+
+            // Align every zone on its newest sample
+            int age = PROFILE_HISTORY - 1 - row;
+            if (age < count) {
+                int sample = SDL_AtomicGet(&history->samples[(head - 1 - age + PROFILE_HISTORY) % PROFILE_HISTORY]);
+                fprintf(f, ",%.4f", sample / 1000000.0);
+            } else {
+                fprintf(f, ",");
+            }
+        }
+        fprintf(f, "\n");
+    }
+
+    fclose(f);
+    printf("Profile written to %s\n", path);
+    return true;
+}
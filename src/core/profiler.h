@@ -0,0 +1,50 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "render_target.h"
+
+// Lightweight scoped timers. Each zone keeps a ring buffer of its most
+// recent samples; a zone must only be timed from one thread.
+
+#define PROFILE_HISTORY 120     // Samples kept per zone (~2 s at 60 Hz)
+
+typedef enum {
+    // Simulation thread
+    PROF_SIM_TOTAL,
+    PROF_SIM_GUESTS,
+    PROF_SIM_RIDES,
+    PROF_SIM_STAFF,
+    PROF_SIM_LITTER,
+    PROF_SIM_WEATHER,
+    PROF_SIM_SNAPSHOT,
+
+    // Render thread
+    PROF_RENDER_TOTAL,
+    PROF_RENDER_SKY,
+    PROF_RENDER_TERRAIN,
+    PROF_RENDER_OBJECTS,
+    PROF_RENDER_ENTITIES,
+    PROF_RENDER_LIGHTS,
+    PROF_RENDER_WEATHER,
+    PROF_UI,
+    PROF_UPLOAD,
+
+    PROF_ZONE_COUNT
+} ProfileZone;
+
+uint64_t profile_now(void);
+void profile_record(ProfileZone zone, uint64_t start);
+
+// Time everything between a matching BEGIN/END pair in the same scope
+#define PROFILE_BEGIN(zone) uint64_t profile_start_##zone = profile_now()
+#define PROFILE_END(zone) profile_record(zone, profile_start_##zone)
+
+// Overlay and export
+void toggle_profiler_overlay(void);
+void draw_profiler_overlay(const RenderTarget* target);
+bool dump_profiler_csv(const char* path);
+
+#endif // PROFILER_H
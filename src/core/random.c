@@ -0,0 +1,48 @@
+#include <stdint.h>
+
+#include "random.h"
+
+#define RAND_DEFAULT_STATE 0x9E3779B97F4A7C15ull
+
+// xorshift64*: one 64-bit word of state per stream, which must never be zero
+static uint64_t g_game_state = RAND_DEFAULT_STATE;
+static uint64_t g_effect_state = RAND_DEFAULT_STATE;
+
+static uint64_t scramble_seed(uint32_t seed) {
+    // splitmix64 finaliser, so nearby seeds give unrelated sequences
+    uint64_t z = (uint64_t)seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return z ? z : RAND_DEFAULT_STATE;
+}
+
+static int next_rand(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (int)((x * 0x2545F4914F6CDD1Dull) >> 33);
+}
+
+void seed_game_rand(uint32_t seed) {
+    g_game_state = scramble_seed(seed);
+    g_effect_state = scramble_seed(~seed);
+}
+
+int game_rand(void) {
+    return next_rand(&g_game_state);
+}
+
+int effect_rand(void) {
+    return next_rand(&g_effect_state);
+}
+
+uint64_t get_game_rand_state(void) {
+    return g_game_state;
+}
+
+void set_game_rand_state(uint64_t state) {
+    if (state) g_game_state = state;
+}
@@ -0,0 +1,28 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+// Seeded random numbers for the simulation. Unlike rand(), the sequence is
+// the same on every platform and C library, so a saved park plus a command
+// journal replays exactly. Only the simulation thread (or code holding the
+// simulation lock) may draw from these.
+
+#define GAME_RAND_MAX 0x7FFFFFFF
+
+void seed_game_rand(uint32_t seed);
+
+// Next value in [0, GAME_RAND_MAX]; a drop-in for rand()
+int game_rand(void);
+
+// A separate stream for purely visual effects such as weather particles,
+// whose spawn counts depend on the window size. Drawing from it never
+// shifts what game_rand() returns.
+int effect_rand(void);
+
+// The gameplay generator state, saved with the park so a loaded park draws
+// the same numbers it would have drawn
+uint64_t get_game_rand_state(void);
+void set_game_rand_state(uint64_t state);
+
+#endif // RANDOM_H
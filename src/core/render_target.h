@@ -0,0 +1,25 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// A 32-bit ARGB pixel buffer: the window framebuffer, a UI window surface or
+// an offscreen image. Every drawing kernel clips against the target it is
+// given, so nothing assumes a fixed screen size.
+//
+// The assembly kernels read these fields by offset (RT_* equates in the .asm
+// files); keep the layout in sync with them.
+typedef struct {
+    uint8_t* pixels;
+    int width;
+    int height;
+    int pitch;          // Bytes per row
+} RenderTarget;
+
+// Address of pixel (x, y); no bounds checking
+static inline uint8_t* render_target_pixel(const RenderTarget* target, int x, int y) {
+    return target->pixels + (size_t)y * target->pitch + (size_t)x * 4;
+}
+
+#endif // RENDER_TARGET_H
@@ -0,0 +1,245 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "replay.h"
+#include "serialize.h"
+
+// Forward declarations
+extern bool save_game(int slot);
+extern bool load_game(int slot);
+extern bool get_save_checksum(int slot, uint32_t* crc);
+extern bool get_state_digest(uint32_t* digest);
+extern void get_command_journal_path(int slot, char* buffer, size_t size);
+extern uint8_t* read_whole_file(const char* path, size_t* size);
+
+extern void lock_simulation(void);
+extern void unlock_simulation(void);
+extern void step_simulation(void);
+extern uint32_t get_simulation_tick(void);
+extern int get_num_guests(void);
+extern int get_park_rating(void);
+extern int get_park_money(void);
+
+extern void apply_tool(int tool, int iso_x, int iso_y);
+extern void select_tool(int tool);
+extern void move_camera(int dx, int dy);
+extern void set_zoom_level(int zoom);
+
+#define REPLAY_MAGIC CHUNK_ID('R', 'C', 'T', 'C')
+#define REPLAY_VERSION 1
+#define COMMAND_SIZE 17
+#define RECORD_FLUSH_BYTES 4096         // Commands buffered before a write
+#define REPLAY_TICKS_PER_SECOND 60.0    // The simulation's fixed step
+
+// Recording runs on the input thread only
+typedef struct {
+    FILE* file;
+    SaveWriter pending;     // Commands not yet written out
+    int commands;
+    bool failed;
+} CommandRecorder;
+
+static CommandRecorder g_recorder = {0};
+
+typedef struct {
+    uint32_t tick;
+    CommandType type;
+    int a, b, c;
+} Command;
+
+static void flush_commands(void) {
+    SaveWriter* w = &g_recorder.pending;
+    if (!w->ok || fwrite(w->data, 1, w->size, g_recorder.file) != w->size ||
+        fflush(g_recorder.file) != 0) {
+        if (!g_recorder.failed) printf("Failed to write command journal\n");
+        g_recorder.failed = true;
+    }
+    w->size = 0;
+}
+
+bool start_recording(int slot) {
+    if (g_recorder.file) return true;
+
+    // Commands are stamped with absolute ticks and the save holds the tick
+    // it was taken at, so a tick that runs between here and the first
+    // command is covered either way
+    uint32_t base;
+    if (!save_game(slot) || !get_save_checksum(slot, &base)) {
+        printf("Failed to save the park to record from\n");
+        return false;
+    }
+
+    char path[256];
+    get_command_journal_path(slot, path, sizeof(path));
+    g_recorder.file = fopen(path, "wb");
+    if (!g_recorder.file) {
+        printf("Failed to create command journal: %s\n", path);
+        return false;
+    }
+
+    writer_init(&g_recorder.pending);
+    g_recorder.commands = 0;
+    g_recorder.failed = false;
+
+    write_u32(&g_recorder.pending, REPLAY_MAGIC);
+    write_u16(&g_recorder.pending, REPLAY_VERSION);
+    write_u16(&g_recorder.pending, 0);
+    write_u32(&g_recorder.pending, base);
+    flush_commands();
+
+    printf("Recording commands to %s\n", path);
+    return true;
+}
+
+void stop_recording(void) {
+    if (!g_recorder.file) return;
+
+    record_command(COMMAND_END, 0, 0, 0);
+    flush_commands();
+    if (fclose(g_recorder.file) != 0) g_recorder.failed = true;
+    g_recorder.file = NULL;
+    writer_free(&g_recorder.pending);
+
+    printf("Recorded %d commands%s\n", g_recorder.commands - 1,
+           g_recorder.failed ? " (journal incomplete)" : "");
+}
+
+bool is_recording(void) {
+    return g_recorder.file != NULL;
+}
+
+void record_command(CommandType type, int a, int b, int c) {
+    if (!g_recorder.file) return;
+
+    SaveWriter* w = &g_recorder.pending;
+    write_u32(w, get_simulation_tick());
+    write_u8(w, (uint8_t)type);
+    write_i32(w, a);
+    write_i32(w, b);
+    write_i32(w, c);
+    g_recorder.commands++;
+
+    if (w->size >= RECORD_FLUSH_BYTES) flush_commands();
+}
+
+static bool read_command(SaveReader* r, Command* command) {
+    if (r->size - r->pos < COMMAND_SIZE) return false;   // End, or a torn tail
+
+    command->tick = read_u32(r);
+    command->type = (CommandType)read_u8(r);
+    command->a = read_i32(r);
+    command->b = read_i32(r);
+    command->c = read_i32(r);
+    return r->ok;
+}
+
+static void apply_command(const Command* command) {
+    switch (command->type) {
+        case COMMAND_SELECT_TOOL:
+            select_tool(command->a);
+            break;
+        case COMMAND_APPLY_TOOL:
+            lock_simulation();
+            apply_tool(command->a, command->b, command->c);
+            unlock_simulation();
+            break;
+        case COMMAND_MOVE_CAMERA:
+            move_camera(command->a, command->b);
+            break;
+        case COMMAND_SET_ZOOM:
+            set_zoom_level(command->a);
+            break;
+        default:
+            break;      // From a newer build; it cannot have changed the park
+    }
+}
+
+bool run_replay(int slot) {
+    char path[256];
+    get_command_journal_path(slot, path, sizeof(path));
+
+    size_t size;
+    uint8_t* data = read_whole_file(path, &size);
+    if (!data) {
+        printf("Failed to read command journal: %s\n", path);
+        return false;
+    }
+
+    SaveReader r;
+    reader_init(&r, data, size);
+    uint32_t magic = read_u32(&r);
+    uint16_t version = read_u16(&r);
+    read_u16(&r);
+    uint32_t base = read_u32(&r);
+
+    uint32_t save_crc;
+    bool ok = true;
+    if (!r.ok || magic != REPLAY_MAGIC || version != REPLAY_VERSION) {
+        printf("Invalid command journal: %s\n", path);
+        ok = false;
+    } else if (!get_save_checksum(slot, &save_crc) || save_crc != base) {
+        printf("Command journal does not belong to the save in slot %d\n", slot);
+        ok = false;
+    } else if (!load_game(slot)) {
+        ok = false;
+    }
+    if (!ok) {
+        free(data);
+        return false;
+    }
+
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    uint64_t total_ticks = 0;
+    uint64_t min_ticks = UINT64_MAX;
+    uint64_t max_ticks = 0;
+    uint32_t start_tick = get_simulation_tick();
+    int applied = 0;
+
+    // Run up to each command's tick, then apply it before that tick runs.
+    // Without an end marker the journal was cut short; stop at its last
+    // complete command.
+    Command command;
+    while (read_command(&r, &command)) {
+        while (get_simulation_tick() < command.tick) {
+            uint64_t start = SDL_GetPerformanceCounter();
+            step_simulation();
+            uint64_t ticks = SDL_GetPerformanceCounter() - start;
+
+            total_ticks += ticks;
+            if (ticks < min_ticks) min_ticks = ticks;
+            if (ticks > max_ticks) max_ticks = ticks;
+        }
+        if (command.type == COMMAND_END) break;
+
+        apply_command(&command);
+        applied++;
+    }
+    free(data);
+
+    uint32_t ran = get_simulation_tick() - start_tick;
+    if (ran > 0) {
+        double total_ms = total_ticks * 1000.0 / frequency;
+        double avg_ms = total_ms / ran;
+        printf("Replayed %u ticks and %d commands in %.1f ms: %.3f ms/tick (min %.3f, max %.3f), %.0fx real time\n",
+               ran, applied, total_ms, avg_ms,
+               min_ticks * 1000.0 / frequency, max_ticks * 1000.0 / frequency,
+               total_ms > 0.0 ? ran / REPLAY_TICKS_PER_SECOND * 1000.0 / total_ms : 0.0);
+    } else {
+        printf("Replayed %d commands with no ticks between them\n", applied);
+    }
+
+    // Compare digests across runs to tell whether a change altered the park
+    uint32_t digest;
+    if (!get_state_digest(&digest)) {
+        printf("Failed to digest the final state\n");
+        return false;
+    }
+    printf("Final state: tick %u, money %d, rating %d, guests %d, digest %08X\n",
+           get_simulation_tick(), get_park_money(), get_park_rating(),
+           get_num_guests(), digest);
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Command journal: every player action, stamped with the simulation tick it
+// was applied before. A save carries the park's tick, timers and random
+// state, so the save a recording starts from plus the commands recorded
+// after it re-run the park exactly, as fast as the machine allows.
+//
+//   journal := magic (u32) | version (u16) | flags (u16) | base (u32) | command*
+//   command := tick (u32) | type (u8) | a (i32) | b (i32) | c (i32)
+//
+// base is the CRC32C of the save the recording started from, so a journal
+// is never replayed over a slot that has since been overwritten.
+
+typedef enum {
+    COMMAND_SELECT_TOOL = 1,    // a = tool
+    COMMAND_APPLY_TOOL,         // a = tool, b, c = tile
+    COMMAND_MOVE_CAMERA,        // a, b = offset in pixels
+    COMMAND_SET_ZOOM,           // a = zoom level
+    COMMAND_END                 // Recording stopped before this tick
+} CommandType;
+
+// Save the park to slot and journal commands against that save until
+// stop_recording()
+bool start_recording(int slot);
+void stop_recording(void);
+bool is_recording(void);
+
+// Append a command at the current tick; does nothing unless recording.
+// Commands that change the park must be recorded while still holding the
+// simulation lock they were applied under, so the tick cannot move on.
+void record_command(CommandType type, int a, int b, int c);
+
+// Load slot, run its command journal with no rendering and no frame pacing,
+// then print tick timings and a digest of the final state
+bool run_replay(int slot);
+
+#endif // REPLAY_H
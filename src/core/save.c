@@ -1,3 +1,4 @@
+#include <SDL2/SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -5,60 +6,324 @@
 #include <string.h>
 #include <time.h>
 #include <sys/stat.h>
-#include <string.h>
 #include <sys/types.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include "serialize.h"
+#include "checksum.h"
+#include "random.h"
+#include "save_stream.h"
+#include "../game/map.h"
 
-#define SAVE_VERSION 1
+#define SAVE_VERSION 4
 #define SAVE_MAGIC 0x52435453  // "RCTS" in hex
-#define MAX_SAVE_SLOTS 10
+#define SAVE_HEADER_SIZE 8     // magic (u32) | version (u16) | flags (u16)
+#define SAVE_FLAG_COMPRESSED 0x0001  // Chunks were written with compression enabled
+#define MAX_SAVE_SLOTS 100
 #define SAVE_DIR "saves"
+#define AUTOSAVE_SLOT 0
+#define SLOT_RECHECK_MS 1000   // Stat sweep interval when the directory is not watched
+#define JOURNAL_MAGIC CHUNK_ID('R', 'C', 'T', 'J')
+#define JOURNAL_VERSION 1
+#define JOURNAL_CHECKPOINT_INTERVAL 10  // Every 10th autosave is a full checkpoint
+#define MAX_STREAMED_CHUNK (256u << 20) // Sanity limit on a chunk read from a file
+#define MAX_MAPPED_SAVE ((int64_t)1 << 30)  // Larger saves are streamed instead
+
+// A save file is a short header followed by tagged chunks (see serialize.h).
+// The park chunk is always first so save info can be read without loading
+// the rest of the file.
+#define CHUNK_PARK    CHUNK_ID('P', 'A', 'R', 'K')
+#define CHUNK_MAP     CHUNK_ID('M', 'A', 'P', ' ')
+#define CHUNK_RIDES   CHUNK_ID('R', 'I', 'D', 'E')
+#define CHUNK_STAFF   CHUNK_ID('S', 'T', 'A', 'F')
+#define CHUNK_SCENERY CHUNK_ID('S', 'C', 'E', 'N')
+#define CHUNK_SHOPS   CHUNK_ID('S', 'H', 'O', 'P')
+#define CHUNK_GUESTS  CHUNK_ID('G', 'U', 'E', 'S')
+#define CHUNK_LITTER  CHUNK_ID('L', 'I', 'T', 'R')
+#define CHUNK_WEATHER CHUNK_ID('W', 'T', 'H', 'R')
+
+// A store's contents, in batches following its chunk (see map.h and
+// RecordStore in serialize.h)
+#define CHUNK_MAP_BATCH     CHUNK_ID('M', 'A', 'P', 'B')
+#define CHUNK_RIDES_BATCH   CHUNK_ID('R', 'I', 'D', 'B')
+#define CHUNK_STAFF_BATCH   CHUNK_ID('S', 'T', 'F', 'B')
+#define CHUNK_SCENERY_BATCH CHUNK_ID('S', 'C', 'N', 'B')
+#define CHUNK_SHOPS_BATCH   CHUNK_ID('S', 'H', 'P', 'B')
+#define CHUNK_GUESTS_BATCH  CHUNK_ID('G', 'U', 'E', 'B')
+#define CHUNK_LITTER_BATCH  CHUNK_ID('L', 'T', 'R', 'B')
 
+// Journal-only chunks
+#define CHUNK_JOURNAL_ENTRY CHUNK_ID('J', 'E', 'N', 'T')
+#define CHUNK_MAP_DELTA     CHUNK_ID('M', 'A', 'P', 'D')
+
+// Park summary shown in the load menu
 typedef struct {
-    uint32_t magic;
-    uint32_t version;
-    time_t timestamp;
+    int64_t timestamp;
     char park_name[64];
     int park_rating;
     int total_money;
     int num_guests;
-    float game_time;
-    float time_of_day;
-} SaveHeader;
+} SaveInfo;
 
 // External getter/setter functions for all game state
 extern void get_park_state(int* rating, int* money, int* guests, float* time, float* tod, int* total_entered, int* entrance_fee);
 extern void set_park_state(int rating, int money, int guests, float time, float tod, int total_entered, int entrance_fee);
+extern void get_park_clock(uint32_t* tick, float* wage_timer, int* last_spawn);
+extern void set_park_clock(uint32_t tick, float wage_timer, int last_spawn);
 
-extern int get_num_rides(void);
-extern void save_ride_data(FILE* f);
-extern void load_ride_data(FILE* f);
+extern const RecordStore* get_ride_store(void);
+extern const RecordStore* get_staff_store(void);
+extern const RecordStore* get_scenery_store(void);
+extern uint32_t get_scenery_generation(void);
+extern const RecordStore* get_shop_store(void);
+extern const RecordStore* get_guest_store(void);
+extern const RecordStore* get_litter_store(void);
 
-extern int get_num_staff(void);
-extern void save_staff_data(FILE* f);
-extern void load_staff_data(FILE* f);
+extern void save_weather_data(SaveWriter* w);
+extern bool load_weather_data(SaveReader* r, uint16_t version);
+extern bool check_weather_data(SaveReader* r, uint16_t version);
 
-extern int get_num_scenery(void);
-extern void save_scenery_data(FILE* f);
-extern void load_scenery_data(FILE* f);
+// Simulation thread synchronization
+extern void lock_simulation(void);
+extern void unlock_simulation(void);
+extern void publish_simulation_snapshot(void);
 
-extern int get_num_shops(void);
-extern void save_shop_data(FILE* f);
-extern void load_shop_data(FILE* f);
+static char g_park_name[64] = "My Amazing Park";
+static bool g_compress_saves = true;
 
-extern void save_guest_data(FILE* f);
-extern void load_guest_data(FILE* f);
+// The files one autosave writes: an optional full checkpoint, then journal
+// bytes that either start a new journal file or are appended to it
+typedef struct {
+    SaveWriter checkpoint;
+    SaveWriter journal;     // Entries only; the header is added when written
+    bool new_journal;
+    bool compress;          // Chunks were serialised raw and still need packing
+} SaveJob;
+
+// Background autosave: the game is serialised into memory between ticks,
+// uncompressed, and this thread compresses and writes it out, so the main
+// loop never waits on compression or the disk.
+// A checkpoint not yet written is replaced by a newer one; journal entries
+// build on each other, so newer ones are queued behind it instead.
+typedef struct {
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    SDL_sem* wake;
+    bool running;           // Guarded by lock
+    bool has_pending;
+    int pending_slot;
+    SaveJob pending;
+} SaveThread;
 
-extern void save_map_data(FILE* f);
-extern void load_map_data(FILE* f);
+static SaveThread g_save_thread = {0};
 
-extern int get_num_litter(void);
-extern void save_litter_data(FILE* f);
-extern void load_litter_data(FILE* f);
+// Cached slot headers for save/load menus, so listing slots does not touch
+// the disk. Entries are re-read only when their file changes: inotify on
+// the save directory reports that on Linux, elsewhere each slot's file is
+// re-stat'd every SLOT_RECHECK_MS. Saves made by this process
+// bump a per-slot counter, so they show up immediately either way.
+typedef struct {
+    bool checked;           // Fields below match the file as last seen
+    bool exists;
+    bool has_info;          // Header and park summary were readable
+    bool intact_known;      // intact holds a full checksum verification
+    bool intact;
+    int64_t mtime;          // mtime, size and inode identify the file version
+    int64_t size;
+    int64_t inode;          // Changes on every atomic replace; 0 on Windows
+    int changes_seen;
+    SaveInfo info;
+} SlotEntry;
 
-extern void save_weather_data(FILE* f);
-extern void load_weather_data(FILE* f);
+typedef struct {
+    SlotEntry slots[MAX_SAVE_SLOTS];
+    SDL_atomic_t changes[MAX_SAVE_SLOTS];  // Bumped by whichever thread writes the slot
+    bool started;
+    int watch_fd;           // inotify descriptor, -1 when polling
+    Uint32 last_sweep;
+} SlotIndex;
 
-static char g_park_name[64] = "My Amazing Park";
+static SlotIndex g_slot_index = {0};
+
+static void save_park_data(SaveWriter* w) {
+    int rating, money, guests, total_entered, entrance_fee;
+    float game_time, tod;
+    get_park_state(&rating, &money, &guests, &game_time, &tod, &total_entered, &entrance_fee);
+
+    // Summary fields first: read_save_info stops after them
+    write_i64(w, (int64_t)time(NULL));
+    write_string(w, g_park_name);
+    write_i32(w, rating);
+    write_i32(w, money);
+    write_i32(w, guests);
+
+    write_f32(w, game_time);
+    write_f32(w, tod);
+    write_i32(w, total_entered);
+    write_i32(w, entrance_fee);
+
+    // Version 2: everything a command replay needs to pick up mid-park
+    uint32_t tick;
+    float wage_timer;
+    int last_spawn;
+    get_park_clock(&tick, &wage_timer, &last_spawn);
+    write_u32(w, tick);
+    write_f32(w, wage_timer);
+    write_i32(w, last_spawn);
+    write_i64(w, (int64_t)get_game_rand_state());
+}
+
+static void read_park_info(SaveReader* r, SaveInfo* info) {
+    info->timestamp = read_i64(r);
+    read_string(r, info->park_name, sizeof(info->park_name));
+    info->park_rating = read_i32(r);
+    info->total_money = read_i32(r);
+    info->num_guests = read_i32(r);
+}
+
+// Everything the park chunk holds besides the guest count
+typedef struct {
+    SaveInfo info;
+    float game_time;
+    float tod;
+    int total_entered;
+    int entrance_fee;
+    uint32_t tick;
+    float wage_timer;
+    int last_spawn;
+    uint64_t rand_state;
+} ParkData;
+
+static bool read_park_data(SaveReader* r, uint16_t version, ParkData* park) {
+    read_park_info(r, &park->info);
+    park->game_time = read_f32(r);
+    park->tod = read_f32(r);
+    park->total_entered = read_i32(r);
+    park->entrance_fee = read_i32(r);
+
+    // Older parks start their clock afresh and keep the current random state
+    park->tick = 0;
+    park->wage_timer = 0.0f;
+    park->last_spawn = 0;
+    park->rand_state = get_game_rand_state();
+    if (version >= 2) {
+        park->tick = read_u32(r);
+        park->wage_timer = read_f32(r);
+        park->last_spawn = read_i32(r);
+        park->rand_state = (uint64_t)read_i64(r);
+    }
+    return r->ok;
+}
+
+static bool check_park_data(SaveReader* r, uint16_t version) {
+    ParkData park;
+    return read_park_data(r, version, &park);
+}
+
+static bool load_park_data(SaveReader* r, uint16_t version) {
+    ParkData park;
+    if (!read_park_data(r, version, &park)) {
+        printf("Invalid park data\n");
+        return false;
+    }
+
+    // The guest count is restored with the guests themselves
+    int rating, money, guests, old_total, old_fee;
+    float old_time, old_tod;
+    get_park_state(&rating, &money, &guests, &old_time, &old_tod, &old_total, &old_fee);
+
+    memcpy(g_park_name, park.info.park_name, sizeof(g_park_name));
+    set_park_state(park.info.park_rating, park.info.total_money, guests, park.game_time, park.tod,
+                   park.total_entered, park.entrance_fee);
+    set_park_clock(park.tick, park.wage_timer, park.last_spawn);
+    set_game_rand_state(park.rand_state);
+    return true;
+}
+
+// Every chunk a save contains, in file order. Versions are per chunk, so a
+// subsystem can change its layout without touching the others. The park
+// chunk is never compressed so save info can be read straight off the file.
+// check reads a chunk through without applying it, so a bad store is
+// caught before any store is loaded. Stores with a batch id are written as
+// their chunk followed by batch chunks: the map, which is read back through
+// a MapCursor rather than load and check, and the entity stores, whose
+// RecordStore (see serialize.h) stands in for all three functions.
+typedef struct {
+    uint32_t id;
+    uint16_t version;
+    bool compressible;
+    const char* name;
+    void (*save)(SaveWriter* w);
+    bool (*load)(SaveReader* r, uint16_t version);
+    bool (*check)(SaveReader* r, uint16_t version);
+    const RecordStore* (*records)(void);    // Entity store, NULL for the rest
+    uint32_t batch_id;      // 0 if the chunk holds everything itself
+    uint32_t (*generation)(void);   // Change counter, NULL if it changes every tick
+} ChunkHandler;
+
+static const ChunkHandler g_chunk_handlers[] = {
+    { CHUNK_PARK,    2, false, "park",    save_park_data,    load_park_data,    check_park_data,    NULL,              0,                   NULL },
+    { CHUNK_MAP,     2, true,  "map",     save_map_data,     NULL,              NULL,               NULL,              CHUNK_MAP_BATCH,     get_map_generation },
+    { CHUNK_RIDES,   2, true,  "rides",   NULL,              NULL,              NULL,               get_ride_store,    CHUNK_RIDES_BATCH,   NULL },
+    { CHUNK_STAFF,   2, true,  "staff",   NULL,              NULL,              NULL,               get_staff_store,   CHUNK_STAFF_BATCH,   NULL },
+    { CHUNK_SCENERY, 2, true,  "scenery", NULL,              NULL,              NULL,               get_scenery_store, CHUNK_SCENERY_BATCH, get_scenery_generation },
+    { CHUNK_SHOPS,   2, true,  "shops",   NULL,              NULL,              NULL,               get_shop_store,    CHUNK_SHOPS_BATCH,   NULL },
+    { CHUNK_GUESTS,  2, true,  "guests",  NULL,              NULL,              NULL,               get_guest_store,   CHUNK_GUESTS_BATCH,  NULL },
+    { CHUNK_LITTER,  2, true,  "litter",  NULL,              NULL,              NULL,               get_litter_store,  CHUNK_LITTER_BATCH,  NULL },
+    { CHUNK_WEATHER, 2, true,  "weather", save_weather_data, load_weather_data, check_weather_data, NULL,              0,                   NULL },
+};
+
+#define NUM_CHUNK_HANDLERS (int)(sizeof(g_chunk_handlers) / sizeof(g_chunk_handlers[0]))
+
+// Autosave journal. Between full checkpoints, an autosave appends one entry
+// to the slot's .jnl file holding only what changed since the previous
+// autosave: stores with a change counter are skipped while it stands still,
+// the map contributes just its edited chunks, and the small stores that
+// change every tick are written whole.
+//
+//   journal := magic (u32) | version (u16) | flags (u16) | base (u32) | entry*
+//   entry   := JENT chunk whose body is the entry's own chunks
+//
+// base is the CRC32C of the checkpoint file, so a journal left over from an
+// older checkpoint is never applied to a newer one. Loading folds the
+// journal over its checkpoint, and the next autosave writes the result back
+// as a fresh checkpoint.
+typedef struct {
+    bool active;            // A checkpoint exists for entries to build on
+    bool started;           // Its journal file has been begun
+    uint32_t base;          // Set and read by whichever thread writes the files
+    int entries;
+    size_t bytes;
+    size_t checkpoint_bytes;
+    uint32_t generations[NUM_CHUNK_HANDLERS];  // Store versions already saved
+    SDL_atomic_t failed;    // Set by the writer when a journal write fails
+} SaveJournal;
+
+static SaveJournal g_journal = {0};
+
+static const ChunkHandler* find_chunk_handler(uint32_t id) {
+    for (int i = 0; i < NUM_CHUNK_HANDLERS; i++) {
+        if (g_chunk_handlers[i].id == id) return &g_chunk_handlers[i];
+    }
+    return NULL;
+}
+
+// The store whose batches use an id, if any
+static const ChunkHandler* find_batch_handler(uint32_t id) {
+    for (int i = 0; i < NUM_CHUNK_HANDLERS; i++) {
+        if (g_chunk_handlers[i].batch_id != 0 && g_chunk_handlers[i].batch_id == id) {
+            return &g_chunk_handlers[i];
+        }
+    }
+    return NULL;
+}
 
 // Ensure save directory exists
 static bool ensure_save_dir(void) {
@@ -75,250 +340,1278 @@ static void get_save_path(int slot, char* buffer, size_t size) {
     snprintf(buffer, size, "%s/park_%d.sav", SAVE_DIR, slot);
 }
 
-// Save the entire game state
-bool save_game(int slot) {
-    if (slot < 0 || slot >= MAX_SAVE_SLOTS) {
-        printf("Invalid save slot: %d\n", slot);
+// A journal sits next to its checkpoint: park_0.sav -> park_0.jnl
+static void get_journal_path(const char* save_path, char* buffer, size_t size) {
+    snprintf(buffer, size, "%s", save_path);
+    size_t length = strlen(buffer);
+    if (length >= 4 && strcmp(buffer + length - 4, ".sav") == 0) length -= 4;
+    snprintf(buffer + length, size - length, ".jnl");
+}
+
+// Commands recorded from a slot's save: park_3.sav -> park_3.cmd
+void get_command_journal_path(int slot, char* buffer, size_t size) {
+    snprintf(buffer, size, "%s/park_%d.cmd", SAVE_DIR, slot);
+}
+
+static void write_save_header(SaveWriter* w) {
+    write_u32(w, SAVE_MAGIC);
+    write_u16(w, SAVE_VERSION);
+    write_u16(w, g_compress_saves ? SAVE_FLAG_COMPRESSED : 0);
+}
+
+static bool check_save_header(SaveReader* r) {
+    uint32_t magic = read_u32(r);
+    uint16_t version = read_u16(r);
+    read_u16(r);            // Flags; each chunk says whether it is compressed
+
+    if (!r->ok || magic != SAVE_MAGIC) {
+        printf("Invalid save file magic\n");
         return false;
     }
-    
-    ensure_save_dir();
-    
-    char filepath[256];
-    get_save_path(slot, filepath, sizeof(filepath));
-    
-    FILE* f = fopen(filepath, "wb");
+    if (version != SAVE_VERSION) {
+        printf("Save file version mismatch\n");
+        return false;
+    }
+    return true;
+}
+
+static void save_store_header(const ChunkHandler* handler, SaveWriter* w) {
+    if (handler->records) {
+        save_records_header(w, handler->records());
+    } else {
+        handler->save(w);
+    }
+}
+
+// A store's contents follow its chunk in batches. Each is flushed once
+// framed when flush is set; inside a journal entry they cannot be.
+static void serialize_store_batches(const ChunkHandler* handler, SaveWriter* w, bool flush) {
+    const RecordStore* store = handler->records ? handler->records() : NULL;
+    int batches = store ? count_record_batches(store) : count_map_batches();
+    int cursor = 0;
+    for (int b = 0; b < batches; b++) {
+        size_t chunk = begin_chunk(w, handler->batch_id, 1);
+        cursor = store ? save_record_batch(w, store, cursor) : save_map_batch(w, cursor);
+        end_chunk(w, chunk);
+        if (flush) writer_flush(w);
+    }
+}
+
+static bool serialize_game_chunks(SaveWriter* w, bool compress) {
+    write_save_header(w);
+    for (int i = 0; i < NUM_CHUNK_HANDLERS; i++) {
+        const ChunkHandler* handler = &g_chunk_handlers[i];
+        w->compress_chunks = compress && handler->compressible;
+        size_t chunk = begin_chunk(w, handler->id, handler->version);
+        save_store_header(handler, w);
+        end_chunk(w, chunk);
+        writer_flush(w);
+
+        if (handler->batch_id) serialize_store_batches(handler, w, true);
+    }
+    w->compress_chunks = false;
+    return w->ok;
+}
+
+// Serialise the entire game state (caller holds the simulation lock). With
+// a sink set on w each chunk is passed on as soon as it is finished, so w
+// never holds more than the largest chunk; otherwise w holds the lot.
+bool serialize_game(SaveWriter* w) {
+    return serialize_game_chunks(w, g_compress_saves);
+}
+
+// Note which store versions a checkpoint holds (caller holds the simulation lock)
+static void record_store_generations(void) {
+    for (int i = 0; i < NUM_CHUNK_HANDLERS; i++) {
+        if (g_chunk_handlers[i].generation) {
+            g_journal.generations[i] = g_chunk_handlers[i].generation();
+        }
+    }
+}
+
+static void write_journal_header(SaveWriter* w) {
+    write_u32(w, JOURNAL_MAGIC);
+    write_u16(w, JOURNAL_VERSION);
+    write_u16(w, 0);        // Flags
+    write_u32(w, g_journal.base);
+}
+
+// Serialise a journal entry with what changed since the previous autosave,
+// uncompressed (caller holds the simulation lock)
+static bool serialize_journal_entry(SaveWriter* w) {
+    size_t entry = begin_chunk(w, CHUNK_JOURNAL_ENTRY, 1);
+    for (int i = 0; i < NUM_CHUNK_HANDLERS; i++) {
+        const ChunkHandler* handler = &g_chunk_handlers[i];
+        uint32_t generation = 0;
+        if (handler->generation) {
+            generation = handler->generation();
+            if (generation == g_journal.generations[i]) continue;
+        }
+
+        if (handler->id == CHUNK_MAP) {
+            size_t chunk = begin_chunk(w, CHUNK_MAP_DELTA, 1);
+            save_map_delta(w, g_journal.generations[i]);
+            end_chunk(w, chunk);
+        } else {
+            size_t chunk = begin_chunk(w, handler->id, handler->version);
+            save_store_header(handler, w);
+            end_chunk(w, chunk);
+            if (handler->batch_id) serialize_store_batches(handler, w, false);
+        }
+        g_journal.generations[i] = generation;
+    }
+
+    end_chunk(w, entry);
+    return w->ok;
+}
+
+// Write a whole file through a temporary that is renamed over it, so a
+// crash mid-write never leaves a half-written file behind
+static bool replace_file(const char* path, const void* data, size_t size) {
+    SaveStream* stream = open_save_output(path);
+    if (!stream) return false;
+
+    bool written = write_save_stream(stream, data, size);
+    return close_save_output(stream, written);
+}
+
+// Append to an existing file and flush it to disk. An append cut short
+// leaves a damaged last entry, which the journal reader stops at.
+static bool append_file(const char* path, const void* data, size_t size) {
+    FILE* f = fopen(path, "r+b");   // Never creates: appends need the header
     if (!f) {
-        printf("Failed to open save file: %s\n", filepath);
         return false;
     }
-    
-    // Write header
-    SaveHeader header = {0};
-    header.magic = SAVE_MAGIC;
-    header.version = SAVE_VERSION;
-    header.timestamp = time(NULL);
-    strncpy(header.park_name, g_park_name, sizeof(header.park_name) - 1);
-    
-    int rating, money, guests, total_entered, entrance_fee;
-    float game_time, tod;
-    get_park_state(&rating, &money, &guests, &game_time, &tod, &total_entered, &entrance_fee);
-    
-    header.park_rating = rating;
-    header.total_money = money;
-    header.num_guests = guests;
-    header.game_time = game_time;
-    header.time_of_day = tod;
-    
-    fwrite(&header, sizeof(SaveHeader), 1, f);
-    
-    // Write park state details
-    fwrite(&total_entered, sizeof(int), 1, f);
-    fwrite(&entrance_fee, sizeof(int), 1, f);
-    
-    // Write map data
-    save_map_data(f);
-    
-    // Write rides
-    int num_rides = get_num_rides();
-    fwrite(&num_rides, sizeof(int), 1, f);
-    save_ride_data(f);
-    
-    // Write staff
-    int num_staff = get_num_staff();
-    fwrite(&num_staff, sizeof(int), 1, f);
-    save_staff_data(f);
-    
-    // Write scenery
-    int num_scenery = get_num_scenery();
-    fwrite(&num_scenery, sizeof(int), 1, f);
-    save_scenery_data(f);
-    
-    // Write shops
-    int num_shops = get_num_shops();
-    fwrite(&num_shops, sizeof(int), 1, f);
-    save_shop_data(f);
-    
-    // Write guests
-    fwrite(&guests, sizeof(int), 1, f);
-    save_guest_data(f);
-    
-    // Write litter
-    int num_litter = get_num_litter();
-    fwrite(&num_litter, sizeof(int), 1, f);
-    save_litter_data(f);
-    
-    // Write weather
-    save_weather_data(f);
-    
-    fclose(f);
-    
-    printf("Game saved to slot %d: %s\n", slot, filepath);
+
+    bool written = fseek(f, 0, SEEK_END) == 0 && fwrite(data, 1, size, f) == size;
+    if (fflush(f) != 0) written = false;
+    #ifndef _WIN32
+    if (written && fsync(fileno(f)) != 0) written = false;
+    #endif
+    if (fclose(f) != 0) written = false;
+    return written;
+}
+
+// Report a slot's file as rewritten, or as having failed to be
+static bool finish_save_write(int slot, const char* filepath, bool written, uint64_t bytes) {
+    if (written) {
+        // Any journal was built on the save just replaced
+        char journal_path[260];
+        get_journal_path(filepath, journal_path, sizeof(journal_path));
+        remove(journal_path);
+    }
+
+    SDL_AtomicIncRef(&g_slot_index.changes[slot]);
+    if (!written) {
+        printf("Failed to write save file: %s\n", filepath);
+        return false;
+    }
+
+    printf("Game saved to slot %d: %s (%llu bytes)\n", slot, filepath, (unsigned long long)bytes);
     return true;
 }
 
-// Load the entire game state
-bool load_game(int slot) {
+// Write a finished save buffer to a slot, replacing the file atomically
+static bool write_save_buffer(int slot, const SaveWriter* w) {
+    ensure_save_dir();
+
+    char filepath[256];
+    get_save_path(slot, filepath, sizeof(filepath));
+    bool written = replace_file(filepath, w->data, w->size);
+    return finish_save_write(slot, filepath, written, w->size);
+}
+
+static void free_save_job(SaveJob* job) {
+    writer_free(&job->checkpoint);
+    writer_free(&job->journal);
+}
+
+// Chunk ids whose bodies compress with a store's: batches go with their
+// store and map deltas with the map
+static bool is_chunk_compressible(uint32_t id) {
+    if (id == CHUNK_MAP_DELTA) id = CHUNK_MAP;
+    const ChunkHandler* handler = find_chunk_handler(id);
+    if (!handler) handler = find_batch_handler(id);
+    return handler && handler->compressible;
+}
+
+// Copy chunks serialised raw into out, compressing each as end_chunk
+// would have. Journal entries are rebuilt around their packed chunks.
+static void pack_chunks(SaveReader* r, SaveWriter* out) {
+    SaveChunk chunk;
+    while (read_chunk(r, &chunk)) {
+        size_t mark = begin_chunk(out, chunk.id, chunk.version);
+        if (chunk.id == CHUNK_JOURNAL_ENTRY) {
+            pack_chunks(&chunk.body, out);
+            out->compress_chunks = false;
+        } else {
+            out->compress_chunks = is_chunk_compressible(chunk.id);
+            write_bytes(out, chunk.body.data, chunk.body.size);
+        }
+        end_chunk(out, mark);
+    }
+    if (!r->ok) out->ok = false;
+}
+
+// Append the chunks of a job buffer, from offset skip on, to out
+static void write_job_chunks(const SaveWriter* job, size_t skip, bool compress, SaveWriter* out) {
+    SaveReader r;
+    reader_init(&r, job->data + skip, job->size - skip);
+    if (compress) {
+        pack_chunks(&r, out);
+    } else {
+        write_bytes(out, r.data, r.size);
+    }
+}
+
+// Write an autosave job's files (on the save thread, or inline without it).
+// Chunks are compressed here rather than under the simulation lock, and the
+// journal base is the CRC of the checkpoint as written. A failure makes the
+// next autosave a fresh checkpoint.
+static bool run_save_job(int slot, SaveJob* job) {
+    bool ok = true;
+    if (job->checkpoint.size > 0) {
+        SaveWriter out;
+        writer_init(&out);
+        ok = job->checkpoint.ok && job->checkpoint.size >= SAVE_HEADER_SIZE;
+        if (ok) {
+            write_bytes(&out, job->checkpoint.data, SAVE_HEADER_SIZE);
+            write_job_chunks(&job->checkpoint, SAVE_HEADER_SIZE, job->compress, &out);
+            ok = out.ok && write_save_buffer(slot, &out);
+        }
+        if (ok) {
+            g_journal.base = crc32c(0, out.data, out.size);
+        }
+        writer_free(&out);
+    }
+
+    // Entries built on a checkpoint that failed to write are dropped
+    if (ok && job->journal.size > 0 && !SDL_AtomicGet(&g_journal.failed)) {
+        char filepath[256];
+        char journal_path[260];
+        get_save_path(slot, filepath, sizeof(filepath));
+        get_journal_path(filepath, journal_path, sizeof(journal_path));
+
+        SaveWriter out;
+        writer_init(&out);
+        if (job->new_journal) write_journal_header(&out);
+        write_job_chunks(&job->journal, 0, job->compress, &out);
+
+        ok = job->journal.ok && out.ok && (job->new_journal
+                 ? replace_file(journal_path, out.data, out.size)
+                 : append_file(journal_path, out.data, out.size));
+        if (ok) {
+            printf("Game saved to slot %d: %s (+%zu bytes)\n", slot, journal_path, out.size);
+        } else {
+            printf("Failed to write save journal: %s\n", journal_path);
+        }
+        writer_free(&out);
+    }
+
+    if (!ok) {
+        SDL_AtomicSet(&g_journal.failed, 1);
+    }
+    return ok;
+}
+
+static bool stream_sink(void* context, const uint8_t* data, size_t size) {
+    return write_save_stream((SaveStream*)context, data, size);
+}
+
+// Save the entire game state (caller holds the simulation lock). Chunks are
+// streamed to the file as they are serialised, and a helper thread writes
+// each block out while the next is filled.
+static bool write_save_file(int slot) {
     if (slot < 0 || slot >= MAX_SAVE_SLOTS) {
         printf("Invalid save slot: %d\n", slot);
         return false;
     }
-    
+
+    ensure_save_dir();
     char filepath[256];
     get_save_path(slot, filepath, sizeof(filepath));
-    
-    FILE* f = fopen(filepath, "rb");
-    if (!f) {
-        printf("Save file not found: %s\n", filepath);
+
+    SaveStream* stream = open_save_output(filepath);
+    bool written = false;
+    uint64_t bytes = 0;
+    if (stream) {
+        SaveWriter w;
+        writer_init(&w);
+        writer_set_sink(&w, stream_sink, stream);
+        bool serialised = serialize_game(&w);
+        writer_free(&w);
+        if (!serialised && !save_stream_failed(stream)) {
+            printf("Failed to serialise game state\n");
+        }
+
+        bytes = get_save_stream_size(stream);
+        written = close_save_output(stream, serialised);
+    }
+    return finish_save_write(slot, filepath, written, bytes);
+}
+
+// A save or journal file's bytes: mapped read-only where the platform
+// allows, read into memory otherwise
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    bool mapped;
+} SaveFileView;
+
+// Read a whole file into a new buffer that the caller frees. NULL if the
+// file is missing or could not be read in full.
+uint8_t* read_whole_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    uint8_t* data = NULL;
+    long length = -1;
+    if (fseek(f, 0, SEEK_END) == 0) length = ftell(f);
+    if (length >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        data = (uint8_t*)malloc(length > 0 ? (size_t)length : 1);
+        if (data && fread(data, 1, (size_t)length, f) != (size_t)length) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+
+    *size = data ? (size_t)length : 0;
+    return data;
+}
+
+// Map a file read-only. Fails for an empty file, one over max_size bytes,
+// or where mapping is not available, leaving the caller to read it instead.
+static bool map_save_file(const char* path, int64_t max_size, SaveFileView* view) {
+    #ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0 && (int64_t)info.st_size <= max_size) {
+        void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);  // The mapping keeps the file referenced
+            #ifdef MADV_SEQUENTIAL
+            madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+            #endif
+            view->data = (const uint8_t*)data;
+            view->size = (size_t)info.st_size;
+            view->mapped = true;
+            return true;
+        }
+    }
+    close(fd);
+    #else
+    (void)path;
+    (void)max_size;
+    (void)view;
+    #endif
+    return false;
+}
+
+static bool open_save_view(const char* path, SaveFileView* view) {
+    if (map_save_file(path, INT64_MAX, view)) return true;
+
+    view->data = read_whole_file(path, &view->size);
+    view->mapped = false;
+    return view->data != NULL;
+}
+
+static void close_save_view(SaveFileView* view) {
+    #ifndef _WIN32
+    if (view->mapped) {
+        munmap((void*)view->data, view->size);
+        view->data = NULL;
+        return;
+    }
+    #endif
+    free((void*)view->data);
+    view->data = NULL;
+}
+
+// Where a save's chunks come from: a buffer in memory, parsed in place, or
+// a file streamed through a bounded ring of blocks (see save_stream.h),
+// where each chunk is copied out whole as it is reached
+typedef struct {
+    SaveReader memory;      // Used when stream is NULL
+    SaveStream* stream;
+    bool truncated;         // The data stopped part way through a chunk
+} ChunkSource;
+
+static void init_memory_source(ChunkSource* source, const uint8_t* data, size_t size) {
+    reader_init(&source->memory, data, size);
+    source->stream = NULL;
+    source->truncated = false;
+}
+
+static void init_stream_source(ChunkSource* source, SaveStream* stream) {
+    reader_init(&source->memory, NULL, 0);
+    source->stream = stream;
+    source->truncated = false;
+}
+
+static bool check_source_header(ChunkSource* source) {
+    if (!source->stream) return check_save_header(&source->memory);
+
+    uint8_t header[SAVE_HEADER_SIZE];
+    SaveReader r;
+    reader_init(&r, header, read_save_stream(source->stream, header, sizeof(header)));
+    return check_save_header(&r);
+}
+
+// Read the next chunk and verify its checksum. A streamed chunk is read
+// into a new buffer handed back in *raw (NULL when parsed in place).
+// Returns false at the end of the data or on a truncated chunk.
+static bool next_save_chunk(ChunkSource* source, SaveChunk* chunk, uint8_t** raw) {
+    *raw = NULL;
+    if (!source->stream) {
+        bool more = read_chunk(&source->memory, chunk);
+        source->truncated = !source->memory.ok;
+        return more;
+    }
+
+    uint8_t header[CHUNK_HEADER_SIZE];
+    size_t got = read_save_stream(source->stream, header, sizeof(header));
+    if (got == 0) return false;
+    if (got != sizeof(header)) {
+        source->truncated = true;
         return false;
     }
-    
-    // Read and validate header
-    SaveHeader header;
-    if (fread(&header, sizeof(SaveHeader), 1, f) != 1) {
-        printf("Failed to read save header\n");
-        fclose(f);
+
+    SaveReader r;
+    reader_init(&r, header, sizeof(header));
+    skip_bytes(&r, 8);
+    uint32_t length = read_u32(&r);
+
+    // A length no save could have is damage, caught before it is allocated
+    uint8_t* data = NULL;
+    if (length <= MAX_STREAMED_CHUNK) {
+        data = (uint8_t*)malloc(CHUNK_HEADER_SIZE + (size_t)length);
+    }
+    if (!data || read_save_stream(source->stream, data + CHUNK_HEADER_SIZE, length) != length) {
+        free(data);
+        source->truncated = true;
         return false;
     }
-    
-    if (header.magic != SAVE_MAGIC) {
-        printf("Invalid save file magic\n");
-        fclose(f);
+
+    memcpy(data, header, CHUNK_HEADER_SIZE);
+    reader_init(&r, data, CHUNK_HEADER_SIZE + (size_t)length);
+    read_chunk(&r, chunk);
+    *raw = data;
+    return true;
+}
+
+// CRC32C of the whole save, once every chunk has been read
+static uint32_t source_checksum(ChunkSource* source) {
+    if (source->stream) return get_save_stream_crc(source->stream);
+    return crc32c(0, source->memory.data, source->memory.size);
+}
+
+// Go back to the start of the save for another pass
+static bool rewind_source(ChunkSource* source) {
+    source->truncated = false;
+    if (source->stream) return rewind_save_input(source->stream);
+
+    source->memory.pos = 0;
+    source->memory.ok = true;
+    return true;
+}
+
+// One pass over a save and its journal. The first pass reads every chunk
+// through without applying anything and notes which copy of each store is
+// the newest: the save's, or that of the last journal entry to hold it.
+// The second applies just those copies, straight into the game.
+typedef struct {
+    bool apply;
+    bool found[NUM_CHUNK_HANDLERS];
+    int source[NUM_CHUNK_HANDLERS]; // Journal entry with the newest copy, -1 for the save
+    int entry;                      // Journal entry being read, -1 for the save
+    int open;                       // Store whose batches may follow, -1 for none
+    bool skipping;                  // The open store is an older copy
+    RecordCursor records;
+    MapCursor map;
+    int map_width;                  // Size of the map deltas apply to
+    int map_height;
+} SaveLoad;
+
+// End the open store, which must have had all its batches
+static bool close_store(SaveLoad* load) {
+    int open = load->open;
+    load->open = -1;
+    if (open < 0 || load->skipping) return true;
+
+    const ChunkHandler* handler = &g_chunk_handlers[open];
+    bool whole = true;
+    if (handler->records) {
+        whole = load->records.done == load->records.count;
+    } else if (handler->id == CHUNK_MAP) {
+        whole = load->map.done == load->map.stored;
+    }
+    if (!whole) {
+        printf("Save has incomplete %s data\n", handler->name);
+    }
+    return whole;
+}
+
+static bool read_store_header(SaveLoad* load, const ChunkHandler* handler, SaveChunk* chunk) {
+    SaveReader* body = &chunk->body;
+    if (handler->records) {
+        return load->apply ? load_records(body, chunk->version, handler->records(), &load->records)
+                           : check_records(body, chunk->version, handler->records(), &load->records);
+    }
+    if (handler->id == CHUNK_MAP) {
+        bool ok = load->apply ? load_map_data(body, chunk->version, &load->map)
+                              : check_map_data(body, chunk->version, &load->map);
+        load->map_width = load->map.width;
+        load->map_height = load->map.height;
+        return ok;
+    }
+    return load->apply ? handler->load(body, chunk->version) : handler->check(body, chunk->version);
+}
+
+static bool read_store_batch(SaveLoad* load, const ChunkHandler* handler, SaveChunk* chunk) {
+    if (handler->records) {
+        return load->apply ? load_record_batch(&chunk->body, &load->records)
+                           : check_record_batch(&chunk->body, &load->records);
+    }
+    return load->apply ? load_map_batch(&chunk->body, &load->map)
+                       : check_map_batch(&chunk->body, &load->map);
+}
+
+// Check or apply one chunk of the save or of a journal entry. Its body is
+// unpacked only for as long as it is being read.
+static bool read_save_chunk(SaveLoad* load, SaveChunk* chunk) {
+    // Checked before the id is trusted: a damaged id would otherwise look
+    // like a chunk from a newer build and be skipped
+    if (!chunk->intact) {
+        printf("Save file is corrupt (chunk checksum mismatch)\n");
         return false;
     }
-    
-    if (header.version != SAVE_VERSION) {
-        printf("Save file version mismatch\n");
-        fclose(f);
+
+    bool delta = load->entry >= 0 && chunk->id == CHUNK_MAP_DELTA;
+    const ChunkHandler* handler = find_chunk_handler(chunk->id);
+    const ChunkHandler* batch = find_batch_handler(chunk->id);
+    if (!delta && !handler && !batch) return true;     // From a newer build; skip it
+
+    if (batch) {
+        if (load->open != (int)(batch - g_chunk_handlers)) {
+            printf("Save has misplaced %s data\n", batch->name);
+            return false;
+        }
+        if (load->skipping) return true;
+    } else {
+        if (!close_store(load)) return false;
+    }
+    if (handler) {
+        int index = (int)(handler - g_chunk_handlers);
+        if (!load->apply) {
+            if (load->found[index] && load->entry < 0) {
+                printf("Save has duplicate %s data\n", handler->name);
+                return false;
+            }
+            load->found[index] = true;
+            load->source[index] = load->entry;
+        }
+        load->open = index;
+        load->skipping = load->apply && load->source[index] != load->entry;
+        if (load->skipping) return true;
+    }
+
+    const char* name = delta ? "journaled map" : (batch ? batch : handler)->name;
+    uint8_t* storage;
+    if (!unpack_chunk(chunk, &storage)) {
+        printf("Save has corrupt %s data\n", name);
+        return false;
+    }
+
+    bool ok;
+    if (delta) {
+        ok = load->apply ? load_map_delta(&chunk->body)
+                         : check_map_delta(&chunk->body, load->map_width, load->map_height);
+    } else if (batch) {
+        ok = read_store_batch(load, batch, chunk);
+    } else {
+        ok = read_store_header(load, handler, chunk);
+    }
+    free(storage);
+
+    if (!ok) {
+        printf(load->apply ? "Failed to load %s data\n" : "Save has invalid %s data\n", name);
+    }
+    return ok;
+}
+
+static bool read_save_chunks(SaveLoad* load, ChunkSource* source) {
+    if (!check_source_header(source)) return false;
+
+    load->entry = -1;
+    bool ok = true;
+    SaveChunk chunk;
+    uint8_t* raw;
+    while (ok && next_save_chunk(source, &chunk, &raw)) {
+        ok = read_save_chunk(load, &chunk);
+        free(raw);
+    }
+    if (ok && source->stream && save_stream_failed(source->stream)) {
+        printf("Failed to read save file\n");
+        ok = false;
+    } else if (ok && source->truncated) {
+        printf("Save file is truncated\n");
+        ok = false;
+    }
+    return ok && close_store(load);
+}
+
+// Position r at the first entry of a journal built on this save. A journal
+// for another checkpoint is ignored.
+static bool open_journal(SaveReader* r, const uint8_t* journal, size_t journal_size, uint32_t save_crc) {
+    reader_init(r, journal, journal_size);
+    uint32_t magic = read_u32(r);
+    uint16_t version = read_u16(r);
+    read_u16(r);            // Flags
+    uint32_t base = read_u32(r);
+    if (!r->ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION) {
+        printf("Ignoring unreadable save journal\n");
+        return false;
+    }
+    if (base != save_crc) {
+        printf("Ignoring save journal from an older checkpoint\n");
         return false;
     }
-    
-    // Read park state details
-    int total_entered, entrance_fee;
-    fread(&total_entered, sizeof(int), 1, f);
-    fread(&entrance_fee, sizeof(int), 1, f);
-    
-    // Restore park state
-    strncpy(g_park_name, header.park_name, sizeof(g_park_name) - 1);
-    set_park_state(header.park_rating, header.total_money, header.num_guests,
-                   header.game_time, header.time_of_day, total_entered, entrance_fee);
-    
-    // Load map data
-    load_map_data(f);
-    
-    // Load rides
-    int num_rides;
-    fread(&num_rides, sizeof(int), 1, f);
-    load_ride_data(f);
-    
-    // Load staff
-    int num_staff;
-    fread(&num_staff, sizeof(int), 1, f);
-    load_staff_data(f);
-    
-    // Load scenery
-    int num_scenery;
-    fread(&num_scenery, sizeof(int), 1, f);
-    load_scenery_data(f);
-    
-    // Load shops
-    int num_shops;
-    fread(&num_shops, sizeof(int), 1, f);
-    load_shop_data(f);
-    
-    // Load guests
-    int num_guests;
-    fread(&num_guests, sizeof(int), 1, f);
-    load_guest_data(f);
-    
-    // Load litter
-    int num_litter;
-    fread(&num_litter, sizeof(int), 1, f);
-    load_litter_data(f);
-    
-    // Load weather
-    load_weather_data(f);
-    
-    fclose(f);
-    
-    printf("Game loaded from slot %d: %s\n", slot, filepath);
     return true;
 }
 
-// Check if a save exists
-bool save_exists(int slot) {
+// Check or apply a journal's entries. Checking counts the complete ones
+// into *entries, stopping at a damaged tail left by an interrupted append;
+// applying reads just that many.
+static bool read_journal(SaveLoad* load, SaveReader* r, int* entries) {
+    int count = 0;
+    bool damaged = false;
+    SaveChunk entry;
+    while ((!load->apply || count < *entries) && read_chunk(r, &entry)) {
+        if (!entry.intact || entry.id != CHUNK_JOURNAL_ENTRY) {
+            damaged = true;
+            break;
+        }
+
+        load->entry = count;
+        SaveChunk chunk;
+        while (read_chunk(&entry.body, &chunk)) {
+            if (!read_save_chunk(load, &chunk)) return false;
+        }
+        if (!entry.body.ok || !close_store(load)) return false;
+        count++;
+    }
+
+    if (!load->apply) {
+        *entries = count;
+        if (damaged || !r->ok) {
+            printf("Save journal has a damaged tail; using its first %d entries\n", count);
+        }
+    }
+    return true;
+}
+
+// Apply a save plus an optional journal (caller holds the simulation lock),
+// in two passes over the file. The first frames, decompresses and checks
+// every chunk and journal entry, so a truncated, corrupt or out-of-range
+// file is rejected without touching the game. The second applies the
+// newest copy of each store. Only one chunk is unpacked at a time and
+// nothing is staged, so beyond the file itself a load needs memory for its
+// largest chunk, not a second copy of the park. A read error or failed
+// allocation in the second pass can still leave the game part loaded.
+static bool apply_save(ChunkSource* source, const uint8_t* journal, size_t journal_size) {
+    SaveLoad load;
+    memset(&load, 0, sizeof(load));
+    load.open = -1;
+    load.map_width = get_map_width();
+    load.map_height = get_map_height();
+    if (!read_save_chunks(&load, source)) return false;
+
+    SaveReader entries;
+    reader_init(&entries, NULL, 0);
+    int num_entries = 0;
+    bool has_journal = journal && open_journal(&entries, journal, journal_size, source_checksum(source));
+    SaveReader first_entry = entries;
+    if (has_journal && !read_journal(&load, &entries, &num_entries)) return false;
+
+    for (int i = 0; i < NUM_CHUNK_HANDLERS; i++) {
+        if (!load.found[i]) {
+            printf("Save has no %s data; keeping current state\n", g_chunk_handlers[i].name);
+        }
+    }
+
+    load.apply = true;
+    if (!rewind_source(source)) {
+        printf("Failed to read save file\n");
+        return false;
+    }
+    if (!read_save_chunks(&load, source)) return false;
+    entries = first_entry;
+    return !has_journal || read_journal(&load, &entries, &num_entries);
+}
+
+// Apply a serialised game state without a journal (caller holds the simulation lock)
+bool deserialize_game(const uint8_t* data, size_t size) {
+    ChunkSource source;
+    init_memory_source(&source, data, size);
+    return apply_save(&source, NULL, 0);
+}
+
+// Load a save file by path, with its journal if there is one (caller holds
+// the simulation lock). The file is mapped, so its chunks are checksummed
+// and parsed in place and uncompressed ones are copied straight into the
+// game. A file too large to map, or one that cannot be, is streamed
+// instead: a helper thread reads ahead while chunks are parsed, and the
+// file is read twice (see apply_save).
+bool load_save_file(const char* path) {
+    SaveFileView file;
+    SaveStream* stream = NULL;
+    bool mapped = map_save_file(path, MAX_MAPPED_SAVE, &file);
+    if (!mapped) {
+        stream = open_save_input(path);
+        if (!stream) {
+            printf("Save file not found: %s\n", path);
+            return false;
+        }
+    }
+
+    char journal_path[260];
+    get_journal_path(path, journal_path, sizeof(journal_path));
+    SaveFileView journal;
+    bool has_journal = open_save_view(journal_path, &journal);
+
+    ChunkSource source;
+    if (mapped) {
+        init_memory_source(&source, file.data, file.size);
+    } else {
+        init_stream_source(&source, stream);
+    }
+    bool loaded = apply_save(&source, has_journal ? journal.data : NULL,
+                             has_journal ? journal.size : 0);
+    if (has_journal) close_save_view(&journal);
+    if (mapped) {
+        close_save_view(&file);
+    } else {
+        close_save_input(stream);
+    }
+
+    if (loaded) {
+        g_journal.active = false;   // The next autosave starts a new checkpoint
+    }
+    return loaded;
+}
+
+// Load the entire game state (caller holds the simulation lock)
+static bool read_save_file(int slot) {
     if (slot < 0 || slot >= MAX_SAVE_SLOTS) {
+        printf("Invalid save slot: %d\n", slot);
         return false;
     }
-    
+
+    char filepath[256];
+    get_save_path(slot, filepath, sizeof(filepath));
+
+    bool loaded = load_save_file(filepath);
+    if (loaded) {
+        printf("Game loaded from slot %d: %s\n", slot, filepath);
+    }
+    return loaded;
+}
+
+// Save between simulation ticks so the state written is consistent
+bool save_game(int slot) {
+    lock_simulation();
+    bool saved = write_save_file(slot);
+    unlock_simulation();
+
+    if (slot == AUTOSAVE_SLOT) {
+        g_journal.active = false;   // Its journal went with the old file
+    }
+    return saved;
+}
+
+// Load between simulation ticks and publish the loaded state right away
+bool load_game(int slot) {
+    lock_simulation();
+    bool loaded = read_save_file(slot);
+    if (loaded) {
+        publish_simulation_snapshot();
+    }
+    unlock_simulation();
+    return loaded;
+}
+
+// CRC32C of a slot's file as it stands, to tie other files to that version
+bool get_save_checksum(int slot, uint32_t* crc) {
+    if (slot < 0 || slot >= MAX_SAVE_SLOTS) return false;
+
     char filepath[256];
     get_save_path(slot, filepath, sizeof(filepath));
-    
-    FILE* f = fopen(filepath, "rb");
+
+    SaveStream* stream = open_save_input(filepath);
+    if (!stream) return false;
+
+    // Skipping to the end runs every block through the checksum
+    while (read_save_stream(stream, NULL, STREAM_BLOCK_SIZE) == STREAM_BLOCK_SIZE) {}
+    bool ok = !save_stream_failed(stream);
+    *crc = get_save_stream_crc(stream);
+    close_save_input(stream);
+    return ok;
+}
+
+// CRC32C of the park as it would be saved, minus the wall-clock timestamp
+// that opens the park chunk. Two runs that end in the same state give the
+// same digest.
+bool get_state_digest(uint32_t* digest) {
+    SaveWriter w;
+    writer_init(&w);
+
+    lock_simulation();
+    bool ok = serialize_game(&w);
+    unlock_simulation();
+
+    // The park chunk comes first and is never compressed
+    size_t park = SAVE_HEADER_SIZE + CHUNK_HEADER_SIZE;
+    SaveReader r;
+    reader_init(&r, w.data, w.size);
+    skip_bytes(&r, SAVE_HEADER_SIZE + 8);
+    size_t park_length = read_u32(&r);
+    if (!ok || !r.ok || park_length < 8 || park + park_length > w.size) {
+        writer_free(&w);
+        return false;
+    }
+
+    uint32_t crc = crc32c(0, w.data + park + 8, park_length - 8);
+    *digest = crc32c(crc, w.data + park + park_length, w.size - park - park_length);
+    writer_free(&w);
+    return true;
+}
+
+// Read the header and park summary at the start of a save file
+static bool read_save_summary(const char* path, SaveInfo* info) {
+    FILE* f = fopen(path, "rb");
     if (!f) {
         return false;
     }
-    
+
+    uint8_t head[SAVE_HEADER_SIZE + CHUNK_HEADER_SIZE + 128];
+    size_t size = fread(head, 1, sizeof(head), f);
     fclose(f);
-    return true;
+
+    SaveReader r;
+    reader_init(&r, head, size);
+    uint32_t magic = read_u32(&r);
+    uint16_t version = read_u16(&r);
+    read_u16(&r);
+    if (magic != SAVE_MAGIC || version != SAVE_VERSION) {
+        return false;
+    }
+
+    // The park chunk may extend past what was read; only its start is needed
+    if (read_u32(&r) != CHUNK_PARK) {
+        return false;
+    }
+    read_u16(&r);           // Version
+    read_u16(&r);           // Flags
+    read_u32(&r);           // Length
+    read_u32(&r);           // Checksum
+
+    read_park_info(&r, info);
+    return r.ok;
 }
 
-// Get save info for display
-bool get_save_info(int slot, char* name, int* rating, int* money, int* guests, time_t* timestamp) {
-    if (slot < 0 || slot >= MAX_SAVE_SLOTS) {
+// True if every chunk in a save file is complete and matches its checksum
+static bool verify_save_file(const char* path) {
+    SaveStream* stream = open_save_input(path);
+    if (!stream) {
         return false;
     }
-    
+
+    ChunkSource source;
+    init_stream_source(&source, stream);
+    bool intact = check_source_header(&source);
+
+    SaveChunk chunk;
+    uint8_t* raw;
+    while (intact && next_save_chunk(&source, &chunk, &raw)) {
+        intact = chunk.intact;
+        free(raw);
+    }
+    intact = intact && !source.truncated && !save_stream_failed(stream);
+
+    close_save_input(stream);
+    return intact;
+}
+
+static bool stat_save_slot(int slot, int64_t* mtime, int64_t* size, int64_t* inode) {
     char filepath[256];
     get_save_path(slot, filepath, sizeof(filepath));
-    
-    FILE* f = fopen(filepath, "rb");
-    if (!f) {
+
+    struct stat info;
+    if (stat(filepath, &info) != 0) {
         return false;
     }
-    
-    SaveHeader header;
-    if (fread(&header, sizeof(SaveHeader), 1, f) != 1) {
-        fclose(f);
+    *mtime = (int64_t)info.st_mtime;
+    *size = (int64_t)info.st_size;
+    *inode = (int64_t)info.st_ino;
+    return true;
+}
+
+static void invalidate_slots(void) {
+    for (int i = 0; i < MAX_SAVE_SLOTS; i++) {
+        g_slot_index.slots[i].checked = false;
+    }
+}
+
+#ifdef __linux__
+static void start_slot_watch(void) {
+    ensure_save_dir();
+    g_slot_index.watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (g_slot_index.watch_fd < 0) return;
+
+    uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE |
+                    IN_DELETE_SELF | IN_MOVE_SELF;
+    if (inotify_add_watch(g_slot_index.watch_fd, SAVE_DIR, mask) < 0) {
+        close(g_slot_index.watch_fd);
+        g_slot_index.watch_fd = -1;
+    }
+}
+
+// Slot number for a file name in the save directory, or -1
+static int parse_slot_name(const char* name) {
+    if (strncmp(name, "park_", 5) != 0) return -1;
+
+    char* end;
+    long slot = strtol(name + 5, &end, 10);
+    if (end == name + 5 || strcmp(end, ".sav") != 0) return -1;
+    return (slot >= 0 && slot < MAX_SAVE_SLOTS) ? (int)slot : -1;
+}
+
+// Drain pending directory events, marking the slots they name
+static void read_slot_events(void) {
+    _Alignas(struct inotify_event) char buffer[4096];
+
+    while (true) {
+        ssize_t length = read(g_slot_index.watch_fd, buffer, sizeof(buffer));
+        if (length <= 0) return;    // EAGAIN: nothing more pending
+
+        for (ssize_t pos = 0; pos < length; ) {
+            const struct inotify_event* event = (const struct inotify_event*)(buffer + pos);
+            pos += (ssize_t)sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // The directory itself went away; watch it again next time
+                close(g_slot_index.watch_fd);
+                g_slot_index.watch_fd = -1;
+                g_slot_index.started = false;
+                invalidate_slots();
+                return;
+            }
+            if (event->mask & IN_Q_OVERFLOW) {
+                invalidate_slots();
+                continue;
+            }
+
+            int slot = event->len > 0 ? parse_slot_name(event->name) : -1;
+            if (slot >= 0) {
+                g_slot_index.slots[slot].checked = false;
+            }
+        }
+    }
+}
+#endif
+
+// Bring the index up to date with the save directory (main thread only)
+static void refresh_slot_index(void) {
+    if (!g_slot_index.started) {
+        g_slot_index.started = true;
+        g_slot_index.watch_fd = -1;
+        #ifdef __linux__
+        start_slot_watch();
+        #endif
+        g_slot_index.last_sweep = SDL_GetTicks();
+        invalidate_slots();
+        return;
+    }
+
+    #ifdef __linux__
+    if (g_slot_index.watch_fd >= 0) {
+        read_slot_events();
+        return;
+    }
+    #endif
+
+    Uint32 now = SDL_GetTicks();
+    if (now - g_slot_index.last_sweep < SLOT_RECHECK_MS) return;
+    g_slot_index.last_sweep = now;
+
+    for (int i = 0; i < MAX_SAVE_SLOTS; i++) {
+        SlotEntry* entry = &g_slot_index.slots[i];
+        int64_t mtime = 0, size = 0, inode = 0;
+        bool exists = stat_save_slot(i, &mtime, &size, &inode);
+        if (exists != entry->exists || mtime != entry->mtime || size != entry->size ||
+            inode != entry->inode) {
+            entry->checked = false;
+        }
+    }
+}
+
+// Cached state of a slot, re-read from disk only if it has changed
+static SlotEntry* get_slot_entry(int slot) {
+    SlotEntry* entry = &g_slot_index.slots[slot];
+    int changes = SDL_AtomicGet(&g_slot_index.changes[slot]);
+    if (entry->checked && entry->changes_seen == changes) {
+        return entry;
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    entry->checked = true;
+    entry->changes_seen = changes;
+    entry->exists = stat_save_slot(slot, &entry->mtime, &entry->size, &entry->inode);
+    if (entry->exists) {
+        char filepath[256];
+        get_save_path(slot, filepath, sizeof(filepath));
+        entry->has_info = read_save_summary(filepath, &entry->info);
+    }
+    return entry;
+}
+
+// Check if a save exists
+bool save_exists(int slot) {
+    if (slot < 0 || slot >= MAX_SAVE_SLOTS) {
         return false;
     }
-    
-    if (header.magic != SAVE_MAGIC) {
-        fclose(f);
+
+    refresh_slot_index();
+    return get_slot_entry(slot)->exists;
+}
+
+// Get save info for display from the slot index. Only the header and the
+// park chunk are read, unless intact is given: then every chunk's checksum
+// is verified too (once per version of the file). A journaled slot shows
+// its last checkpoint.
+bool get_save_info(int slot, char* name, int* rating, int* money, int* guests, time_t* timestamp,
+                   bool* intact) {
+    if (slot < 0 || slot >= MAX_SAVE_SLOTS) {
         return false;
     }
-    
-    strncpy(name, header.park_name, 63);
-    name[63] = '\0';
-    *rating = header.park_rating;
-    *money = header.total_money;
-    *guests = header.num_guests;
-    *timestamp = header.timestamp;
-    
-    fclose(f);
+
+    refresh_slot_index();
+    SlotEntry* entry = get_slot_entry(slot);
+    if (!entry->has_info) {
+        return false;
+    }
+
+    if (intact) {
+        if (!entry->intact_known) {
+            char filepath[256];
+            get_save_path(slot, filepath, sizeof(filepath));
+            entry->intact = verify_save_file(filepath);
+            entry->intact_known = true;
+        }
+        *intact = entry->intact;
+    }
+
+    const SaveInfo* info = &entry->info;
+    memcpy(name, info->park_name, 64);
+    *rating = info->park_rating;
+    *money = info->total_money;
+    *guests = info->num_guests;
+    *timestamp = (time_t)info->timestamp;
     return true;
 }
 
+// Fill slots with the numbers of occupied save slots in ascending order;
+// returns how many were found (at most max_slots)
+int list_save_slots(int* slots, int max_slots) {
+    refresh_slot_index();
+
+    int count = 0;
+    for (int i = 0; i < MAX_SAVE_SLOTS && count < max_slots; i++) {
+        if (get_slot_entry(i)->exists) {
+            slots[count++] = i;
+        }
+    }
+    return count;
+}
+
 // Delete a save
 bool delete_save(int slot) {
     if (slot < 0 || slot >= MAX_SAVE_SLOTS) {
         return false;
     }
-    
+
     char filepath[256];
     get_save_path(slot, filepath, sizeof(filepath));
-    
-    if (remove(filepath) == 0) {
+
+    char journal_path[260];
+    get_journal_path(filepath, journal_path, sizeof(journal_path));
+    remove(journal_path);
+    get_command_journal_path(slot, journal_path, sizeof(journal_path));
+    remove(journal_path);
+
+    bool deleted = remove(filepath) == 0;
+    SDL_AtomicIncRef(&g_slot_index.changes[slot]);
+    if (deleted) {
         printf("Deleted save slot %d\n", slot);
-        return true;
     }
-    
-    return false;
+    return deleted;
+}
+
+static int save_thread_main(void* data) {
+    (void)data;
+
+    while (true) {
+        SDL_SemWait(g_save_thread.wake);
+
+        SDL_LockMutex(g_save_thread.lock);
+        bool running = g_save_thread.running;
+        bool has_job = g_save_thread.has_pending;
+        int slot = g_save_thread.pending_slot;
+        SaveJob job = g_save_thread.pending;
+        g_save_thread.has_pending = false;
+        writer_init(&g_save_thread.pending.checkpoint);
+        writer_init(&g_save_thread.pending.journal);
+        SDL_UnlockMutex(g_save_thread.lock);
+
+        if (has_job) {
+            run_save_job(slot, &job);
+            free_save_job(&job);
+        }
+        if (!running) break;
+    }
+
+    return 0;
+}
+
+bool start_save_thread(void) {
+    if (g_save_thread.thread) return true;
+
+    g_save_thread.lock = SDL_CreateMutex();
+    g_save_thread.wake = SDL_CreateSemaphore(0);
+    if (!g_save_thread.lock || !g_save_thread.wake) {
+        printf("Save thread setup failed: %s\n", SDL_GetError());
+        if (g_save_thread.lock) SDL_DestroyMutex(g_save_thread.lock);
+        if (g_save_thread.wake) SDL_DestroySemaphore(g_save_thread.wake);
+        g_save_thread.lock = NULL;
+        g_save_thread.wake = NULL;
+        return false;
+    }
+
+    writer_init(&g_save_thread.pending.checkpoint);
+    writer_init(&g_save_thread.pending.journal);
+    g_save_thread.has_pending = false;
+    g_save_thread.running = true;
+    g_save_thread.thread = SDL_CreateThread(save_thread_main, "save", NULL);
+    if (!g_save_thread.thread) {
+        printf("Save thread creation failed: %s\n", SDL_GetError());
+        SDL_DestroyMutex(g_save_thread.lock);
+        SDL_DestroySemaphore(g_save_thread.wake);
+        g_save_thread.lock = NULL;
+        g_save_thread.wake = NULL;
+        return false;
+    }
+
+    return true;
 }
 
-// Auto-save
+// Finish any pending autosave, then stop the thread
+void stop_save_thread(void) {
+    if (!g_save_thread.thread) return;
+
+    SDL_LockMutex(g_save_thread.lock);
+    g_save_thread.running = false;
+    SDL_UnlockMutex(g_save_thread.lock);
+    SDL_SemPost(g_save_thread.wake);
+    SDL_WaitThread(g_save_thread.thread, NULL);
+    g_save_thread.thread = NULL;
+
+    free_save_job(&g_save_thread.pending);
+    SDL_DestroyMutex(g_save_thread.lock);
+    SDL_DestroySemaphore(g_save_thread.wake);
+    g_save_thread.lock = NULL;
+    g_save_thread.wake = NULL;
+}
+
+// Auto-save. Only the uncompressed serialisation happens here (between
+// simulation ticks); the save thread, if running, compresses and writes.
+// Most autosaves are journal entries; a full checkpoint is written every
+// JOURNAL_CHECKPOINT_INTERVAL autosaves, or sooner if the journal grows
+// past half the checkpoint's size.
 bool auto_save(void) {
-    return save_game(0);  // Slot 0 is auto-save
+    if (SDL_AtomicSet(&g_journal.failed, 0)) {
+        g_journal.active = false;   // A write failed; start over from a checkpoint
+    }
+    bool checkpoint = !g_journal.active ||
+                      g_journal.entries >= JOURNAL_CHECKPOINT_INTERVAL - 1 ||
+                      g_journal.bytes > g_journal.checkpoint_bytes / 2;
+
+    SaveJob job;
+    writer_init(&job.checkpoint);
+    writer_init(&job.journal);
+    job.new_journal = false;
+    job.compress = g_compress_saves;
+
+    // Serialised raw: compression is left to the save thread
+    lock_simulation();
+    bool serialized;
+    if (checkpoint) {
+        serialized = serialize_game_chunks(&job.checkpoint, false);
+        record_store_generations();
+    } else {
+        job.new_journal = !g_journal.started;
+        serialized = serialize_journal_entry(&job.journal);
+    }
+    unlock_simulation();
+
+    if (!serialized) {
+        printf("Failed to serialise game state\n");
+        free_save_job(&job);
+        g_journal.active = false;
+        return false;
+    }
+
+    if (checkpoint) {
+        g_journal.active = true;
+        g_journal.started = false;
+        g_journal.entries = 0;
+        g_journal.bytes = 0;
+        g_journal.checkpoint_bytes = job.checkpoint.size;
+    } else {
+        g_journal.started = true;
+        g_journal.entries++;
+        g_journal.bytes += job.journal.size;
+    }
+
+    if (!g_save_thread.thread) {
+        bool saved = run_save_job(AUTOSAVE_SLOT, &job);
+        free_save_job(&job);
+        return saved;
+    }
+
+    SDL_LockMutex(g_save_thread.lock);
+    SaveJob* pending = &g_save_thread.pending;
+    if (checkpoint || !g_save_thread.has_pending) {
+        free_save_job(pending);     // A checkpoint supersedes anything unwritten
+        *pending = job;
+    } else {
+        if (pending->journal.size == 0) pending->new_journal = job.new_journal;
+        write_bytes(&pending->journal, job.journal.data, job.journal.size);
+        free_save_job(&job);
+    }
+    g_save_thread.pending_slot = AUTOSAVE_SLOT;
+    g_save_thread.has_pending = true;
+    SDL_UnlockMutex(g_save_thread.lock);
+
+    SDL_SemPost(g_save_thread.wake);
+    return true;
+}
+
+// Compress chunks in future saves (on by default). Loading handles both.
+void set_save_compression(bool enabled) {
+    g_compress_saves = enabled;
 }
 
 // Set park name
@@ -0,0 +1,273 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "serialize.h"
+
+// Save format benchmark: encode, write and read times and file size, with
+// and without chunk compression. Run with --bench-save (or `make bench`).
+
+extern void init_simulation(void);
+extern bool load_game(int slot);
+extern bool serialize_game(SaveWriter* w);
+extern bool load_save_file(const char* path);
+extern void set_save_compression(bool enabled);
+extern bool create_map(int width, int height);
+extern void set_tile_height(int x, int y, int height);
+
+#define BENCH_SLOT 2                // Benchmarked if present, else a fresh park
+#define BENCH_FILE "saves/bench.tmp"
+#define BENCH_PARK_RUNS 200
+#define BENCH_GUEST_RUNS 10
+#define SYNTHETIC_GUESTS 50000
+#define LARGE_MAP_SIZE 1024
+#define CHUNK_TILES 32              // CHUNK_SIZE in map.h
+
+typedef struct {
+    size_t bytes;
+    double encode_ms;
+    double write_ms;
+    double read_ms;
+} BenchResult;
+
+static double g_ticks_to_ms = 0.0;
+
+static double elapsed_ms(uint64_t start) {
+    return (SDL_GetPerformanceCounter() - start) * g_ticks_to_ms;
+}
+
+// Write to the page cache only (no fsync), so this measures our cost rather
+// than the disk's
+static bool write_bench_file(const SaveWriter* w) {
+    FILE* f = fopen(BENCH_FILE, "wb");
+    if (!f) {
+        printf("Failed to open %s\n", BENCH_FILE);
+        return false;
+    }
+    bool ok = fwrite(w->data, 1, w->size, f) == w->size;
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+static uint8_t* read_bench_file(size_t size) {
+    FILE* f = fopen(BENCH_FILE, "rb");
+    if (!f) return NULL;
+    uint8_t* data = (uint8_t*)malloc(size > 0 ? size : 1);
+    if (data && fread(data, 1, size, f) != size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+// Full save and load of the current park through the real chunk handlers
+// and the same file path load_game uses
+static bool bench_park(bool compress, int runs, BenchResult* result) {
+    memset(result, 0, sizeof(*result));
+    set_save_compression(compress);
+
+    for (int run = 0; run < runs; run++) {
+        SaveWriter w;
+        writer_init(&w);
+
+        uint64_t start = SDL_GetPerformanceCounter();
+        bool ok = serialize_game(&w);
+        result->encode_ms += elapsed_ms(start);
+
+        start = SDL_GetPerformanceCounter();
+        ok = ok && write_bench_file(&w);
+        result->write_ms += elapsed_ms(start);
+
+        start = SDL_GetPerformanceCounter();
+        ok = ok && load_save_file(BENCH_FILE);
+        result->read_ms += elapsed_ms(start);
+
+        result->bytes = w.size;
+        writer_free(&w);
+        if (!ok) return false;
+    }
+
+    result->encode_ms /= runs;
+    result->write_ms /= runs;
+    result->read_ms /= runs;
+    return true;
+}
+
+// Touch every chunk of the largest map so all of them are allocated and saved
+static bool build_large_map(void) {
+    if (!create_map(LARGE_MAP_SIZE, LARGE_MAP_SIZE)) return false;
+    for (int y = 0; y < LARGE_MAP_SIZE; y += CHUNK_TILES) {
+        for (int x = 0; x < LARGE_MAP_SIZE; x += CHUNK_TILES) {
+            set_tile_height(x + (rand() % CHUNK_TILES), y + (rand() % CHUNK_TILES), 1 + rand() % 8);
+        }
+    }
+    return true;
+}
+
+// The chunks a store of far more guests than MAX_GUESTS allows would be
+// saved as, uncompressed: its header and batches of RECORD_BATCH_SIZE
+// records in the guest store's layout, with plausible value ranges
+static void build_synthetic_guests(SaveWriter* w) {
+    static const char* thoughts[] = {
+        "Wow! This park looks great!", "I'm hungry", "I'm thirsty",
+        "I need a bathroom", "I'm tired", "This ride was great!"
+    };
+    static const uint32_t colors[] = { 0xFF00FF, 0x00FFFF, 0xFFFF00, 0xFF8800, 0x00FF88 };
+
+    srand(1);
+    size_t chunk = begin_chunk(w, CHUNK_ID('G', 'U', 'E', 'S'), 2);
+    write_u32(w, SYNTHETIC_GUESTS);
+    end_chunk(w, chunk);
+
+    for (int i = 0; i < SYNTHETIC_GUESTS; i++) {
+        if (i % RECORD_BATCH_SIZE == 0) {
+            if (i > 0) end_chunk(w, chunk);
+            chunk = begin_chunk(w, CHUNK_ID('G', 'U', 'E', 'B'), 1);
+            int count = SYNTHETIC_GUESTS - i;
+            write_u32(w, (uint32_t)(count < RECORD_BATCH_SIZE ? count : RECORD_BATCH_SIZE));
+        }
+
+        size_t record = begin_record(w);
+        write_f32(w, (float)(rand() % 256000) / 250.0f);
+        write_f32(w, (float)(rand() % 256000) / 250.0f);
+        write_f32(w, (float)(rand() % 1024));
+        write_f32(w, (float)(rand() % 1024));
+        write_f32(w, 2.0f + (rand() % 100) / 100.0f);
+        write_i32(w, 50 + rand() % 50);
+        write_i32(w, rand() % 100);
+        write_i32(w, rand() % 100);
+        write_i32(w, rand() % 100);
+        write_i32(w, rand() % 100);
+        write_i32(w, rand() % 150);
+        write_u8(w, (uint8_t)(rand() % 2));
+        write_u32(w, colors[i % 5]);
+        write_u8(w, (uint8_t)(rand() % 5));
+        write_i32(w, rand() % 3 - 1);
+        write_i32(w, rand() % 3 - 1);
+        write_string(w, thoughts[rand() % 6]);
+        write_f32(w, (float)(rand() % 30));
+        end_record(w, record);
+    }
+    end_chunk(w, chunk);
+}
+
+// Chunk framing, compression, file I/O and decompression of the synthetic
+// guests, one chunk at a time as a save and load would; the records are
+// not applied since they exceed MAX_GUESTS
+static bool bench_guests(const SaveWriter* chunks, bool compress, BenchResult* result) {
+    memset(result, 0, sizeof(*result));
+
+    for (int run = 0; run < BENCH_GUEST_RUNS; run++) {
+        SaveWriter w;
+        writer_init(&w);
+        w.compress_chunks = compress;
+
+        uint64_t start = SDL_GetPerformanceCounter();
+        SaveReader r;
+        SaveChunk chunk;
+        size_t body_bytes = 0;
+        reader_init(&r, chunks->data, chunks->size);
+        while (read_chunk(&r, &chunk)) {
+            size_t mark = begin_chunk(&w, chunk.id, chunk.version);
+            write_bytes(&w, chunk.body.data, chunk.body.size);
+            end_chunk(&w, mark);
+            body_bytes += chunk.body.size;
+        }
+        bool ok = w.ok && r.ok;
+        result->encode_ms += elapsed_ms(start);
+
+        start = SDL_GetPerformanceCounter();
+        ok = ok && write_bench_file(&w);
+        result->write_ms += elapsed_ms(start);
+
+        start = SDL_GetPerformanceCounter();
+        uint8_t* data = ok ? read_bench_file(w.size) : NULL;
+        reader_init(&r, data, data ? w.size : 0);
+        size_t read_bytes = 0;
+        while (ok && read_chunk(&r, &chunk)) {
+            uint8_t* storage = NULL;
+            ok = chunk.intact && unpack_chunk(&chunk, &storage);
+            read_bytes += chunk.body.size;
+            free(storage);
+        }
+        ok = ok && data && r.ok && read_bytes == body_bytes;
+        result->read_ms += elapsed_ms(start);
+
+        result->bytes = w.size;
+        free(data);
+        writer_free(&w);
+        if (!ok) return false;
+    }
+
+    result->encode_ms /= BENCH_GUEST_RUNS;
+    result->write_ms /= BENCH_GUEST_RUNS;
+    result->read_ms /= BENCH_GUEST_RUNS;
+    return true;
+}
+
+static void print_result(const char* data, const char* format, const BenchResult* result) {
+    printf("%-24s %-11s %10zu %10.3f %10.3f %10.3f\n", data, format, result->bytes,
+           result->encode_ms, result->write_ms, result->read_ms);
+}
+
+bool run_save_benchmark(void) {
+    g_ticks_to_ms = 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    #ifdef _WIN32
+    mkdir("saves");
+    #else
+    mkdir("saves", 0755);
+    #endif
+
+    init_simulation();
+    char park_label[32];
+    if (load_game(BENCH_SLOT)) {
+        snprintf(park_label, sizeof(park_label), "park (slot %d)", BENCH_SLOT);
+    } else {
+        snprintf(park_label, sizeof(park_label), "park (new)");
+    }
+
+    BenchResult raw, packed, large_raw, large_packed;
+    bool ok = bench_park(false, BENCH_PARK_RUNS, &raw) && bench_park(true, BENCH_PARK_RUNS, &packed);
+    ok = ok && build_large_map() &&
+         bench_park(false, BENCH_GUEST_RUNS, &large_raw) && bench_park(true, BENCH_GUEST_RUNS, &large_packed);
+    set_save_compression(true);
+    if (!ok) {
+        printf("Park save benchmark failed\n");
+        remove(BENCH_FILE);
+        return false;
+    }
+
+    printf("\n%-24s %-11s %10s %10s %10s %10s\n", "data", "format", "bytes",
+           "encode ms", "write ms", "read ms");
+    print_result(park_label, "raw", &raw);
+    print_result(park_label, "compressed", &packed);
+
+    char map_label[32];
+    snprintf(map_label, sizeof(map_label), "%dx%d map", LARGE_MAP_SIZE, LARGE_MAP_SIZE);
+    print_result(map_label, "raw", &large_raw);
+    print_result(map_label, "compressed", &large_packed);
+
+    SaveWriter guests;
+    writer_init(&guests);
+    build_synthetic_guests(&guests);
+    ok = guests.ok && bench_guests(&guests, false, &raw) && bench_guests(&guests, true, &packed);
+    writer_free(&guests);
+    remove(BENCH_FILE);
+    if (!ok) {
+        printf("Guest save benchmark failed\n");
+        return false;
+    }
+
+    char guest_label[32];
+    snprintf(guest_label, sizeof(guest_label), "%d guests (synthetic)", SYNTHETIC_GUESTS);
+    print_result(guest_label, "raw", &raw);
+    print_result(guest_label, "compressed", &packed);
+    return true;
+}
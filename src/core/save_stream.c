@@ -0,0 +1,312 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "save_stream.h"
+#include "checksum.h"
+
+// Blocks pass round the ring in order. The caller owns the block at
+// current; the helper owns the ones it has been handed. Output blocks carry
+// data to the writer and an empty block ends the output; input blocks carry
+// data back, and a short block is the last.
+struct SaveStream {
+    FILE* file;
+    char path[280];
+    char temppath[290];
+
+    uint8_t* blocks[STREAM_BLOCKS];     // Only the first until a helper starts
+    size_t lengths[STREAM_BLOCKS];
+    SDL_sem* filled;        // Blocks handed to the consumer side
+    SDL_sem* free_blocks;   // Blocks the producer side may fill
+    SDL_Thread* thread;
+    bool no_helper;         // Starting one failed; work inline
+    SDL_atomic_t stopping;  // Input: stop reading ahead
+    SDL_atomic_t failed;
+
+    int current;
+    size_t pos;
+    size_t length;          // Input: bytes in the current block
+    bool at_end;            // Input: the current block is the last
+
+    uint64_t bytes;         // Output: written by the caller so far
+    uint32_t crc;           // Input: of every block read so far
+};
+
+static void free_stream(SaveStream* s) {
+    if (s->file) fclose(s->file);
+    if (s->filled) SDL_DestroySemaphore(s->filled);
+    if (s->free_blocks) SDL_DestroySemaphore(s->free_blocks);
+    for (int i = 0; i < STREAM_BLOCKS; i++) {
+        free(s->blocks[i]);
+    }
+    free(s);
+}
+
+// Start the helper once a stream turns out to need more than one block.
+// The caller keeps the block it holds; the rest of the ring starts free.
+static bool start_helper(SaveStream* s, SDL_ThreadFunction run, const char* name) {
+    for (int i = 1; i < STREAM_BLOCKS; i++) {
+        if (!s->blocks[i]) s->blocks[i] = (uint8_t*)malloc(STREAM_BLOCK_SIZE);
+        if (!s->blocks[i]) return false;
+    }
+
+    s->filled = SDL_CreateSemaphore(0);
+    s->free_blocks = SDL_CreateSemaphore(STREAM_BLOCKS - 1);
+    if (!s->filled || !s->free_blocks) return false;
+
+    s->thread = SDL_CreateThread(run, name, s);
+    return s->thread != NULL;
+}
+
+static void write_block(SaveStream* s, const uint8_t* data, size_t length) {
+    if (SDL_AtomicGet(&s->failed)) return;     // Already lost; skip the disk
+    if (fwrite(data, 1, length, s->file) != length) {
+        SDL_AtomicSet(&s->failed, 1);
+    }
+}
+
+static int output_thread(void* data) {
+    SaveStream* s = (SaveStream*)data;
+    int index = 0;
+
+    while (true) {
+        SDL_SemWait(s->filled);
+        size_t length = s->lengths[index];
+        if (length == 0) break;
+
+        write_block(s, s->blocks[index], length);
+        SDL_SemPost(s->free_blocks);
+        index = (index + 1) % STREAM_BLOCKS;
+    }
+
+    return 0;
+}
+
+// Hand the current block (length bytes, 0 to end the output) to the writer
+// and move on to the next free one
+static void submit_block(SaveStream* s, size_t length) {
+    if (!s->thread && !s->no_helper && length == STREAM_BLOCK_SIZE) {
+        if (!start_helper(s, output_thread, "save_writer")) s->no_helper = true;
+    }
+
+    s->pos = 0;
+    if (!s->thread) {
+        if (length > 0) write_block(s, s->blocks[0], length);
+        return;
+    }
+
+    s->lengths[s->current] = length;
+    SDL_SemPost(s->filled);
+    if (length == 0) return;
+
+    s->current = (s->current + 1) % STREAM_BLOCKS;
+    SDL_SemWait(s->free_blocks);
+}
+
+SaveStream* open_save_output(const char* path) {
+    SaveStream* s = (SaveStream*)calloc(1, sizeof(SaveStream));
+    if (!s) return NULL;
+
+    snprintf(s->path, sizeof(s->path), "%s", path);
+    snprintf(s->temppath, sizeof(s->temppath), "%s.tmp", path);
+    s->blocks[0] = (uint8_t*)malloc(STREAM_BLOCK_SIZE);
+    if (s->blocks[0]) s->file = fopen(s->temppath, "wb");
+
+    if (!s->file) {
+        printf("Failed to open save file: %s\n", s->temppath);
+        free_stream(s);
+        return NULL;
+    }
+    return s;
+}
+
+bool write_save_stream(SaveStream* s, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    while (size > 0) {
+        size_t count = STREAM_BLOCK_SIZE - s->pos;
+        if (count > size) count = size;
+
+        memcpy(s->blocks[s->current] + s->pos, bytes, count);
+        s->pos += count;
+        s->bytes += count;
+        bytes += count;
+        size -= count;
+
+        if (s->pos == STREAM_BLOCK_SIZE) submit_block(s, s->pos);
+    }
+    return !SDL_AtomicGet(&s->failed);
+}
+
+// Finish an output stream. The file is flushed to disk before the rename,
+// so a crash never leaves a half-written file behind.
+bool close_save_output(SaveStream* s, bool commit) {
+    if (s->pos > 0) submit_block(s, s->pos);
+    if (s->thread) {
+        submit_block(s, 0);
+        SDL_WaitThread(s->thread, NULL);
+        s->thread = NULL;
+    }
+
+    bool written = commit && !SDL_AtomicGet(&s->failed);
+    if (fflush(s->file) != 0) written = false;
+    #ifndef _WIN32
+    if (written && fsync(fileno(s->file)) != 0) written = false;
+    #endif
+    if (fclose(s->file) != 0) written = false;
+    s->file = NULL;
+
+    #ifdef _WIN32
+    if (written) remove(s->path);   // rename() does not replace on Windows
+    #endif
+    if (!written || rename(s->temppath, s->path) != 0) {
+        remove(s->temppath);
+        written = false;
+    }
+
+    free_stream(s);
+    return written;
+}
+
+// Read the next block of the file into blocks[index]; false once that was
+// the last
+static bool read_block(SaveStream* s, int index) {
+    size_t length = fread(s->blocks[index], 1, STREAM_BLOCK_SIZE, s->file);
+    if (length < STREAM_BLOCK_SIZE && ferror(s->file)) {
+        SDL_AtomicSet(&s->failed, 1);
+    }
+
+    s->lengths[index] = length;
+    s->crc = crc32c(s->crc, s->blocks[index], length);
+    return length == STREAM_BLOCK_SIZE;
+}
+
+static int input_thread(void* data) {
+    SaveStream* s = (SaveStream*)data;
+    int index = 1;          // The first block was read when the stream opened
+
+    while (true) {
+        SDL_SemWait(s->free_blocks);
+        if (SDL_AtomicGet(&s->stopping)) break;
+
+        bool more = read_block(s, index);
+        SDL_SemPost(s->filled);
+        if (!more) break;
+        index = (index + 1) % STREAM_BLOCKS;
+    }
+
+    return 0;
+}
+
+// Read the first block, and read ahead on a helper if there is more. A
+// file that fits in one block is read inline.
+static void start_input(SaveStream* s) {
+    bool more = read_block(s, 0);
+    s->current = 0;
+    s->pos = 0;
+    s->length = s->lengths[0];
+    s->at_end = !more;
+    if (more && !s->no_helper && !start_helper(s, input_thread, "save_reader")) {
+        s->no_helper = true;
+    }
+}
+
+SaveStream* open_save_input(const char* path) {
+    SaveStream* s = (SaveStream*)calloc(1, sizeof(SaveStream));
+    if (!s) return NULL;
+
+    snprintf(s->path, sizeof(s->path), "%s", path);
+    s->blocks[0] = (uint8_t*)malloc(STREAM_BLOCK_SIZE);
+    if (s->blocks[0]) s->file = fopen(path, "rb");
+    if (!s->file) {
+        free_stream(s);
+        return NULL;
+    }
+
+    start_input(s);
+    return s;
+}
+
+// Stop reading ahead and take the ring back from the helper
+static void stop_input_helper(SaveStream* s) {
+    if (!s->thread) return;
+
+    SDL_AtomicSet(&s->stopping, 1);
+    SDL_SemPost(s->free_blocks);    // Wake it if it is waiting for a block
+    SDL_WaitThread(s->thread, NULL);
+    s->thread = NULL;
+    SDL_AtomicSet(&s->stopping, 0);
+
+    SDL_DestroySemaphore(s->filled);
+    SDL_DestroySemaphore(s->free_blocks);
+    s->filled = NULL;
+    s->free_blocks = NULL;
+}
+
+bool rewind_save_input(SaveStream* s) {
+    stop_input_helper(s);
+    if (fseek(s->file, 0, SEEK_SET) != 0) {
+        SDL_AtomicSet(&s->failed, 1);
+        return false;
+    }
+
+    s->crc = 0;
+    start_input(s);
+    return !SDL_AtomicGet(&s->failed);
+}
+
+// Give the current block back and take the next one; false at the end
+static bool next_input_block(SaveStream* s) {
+    if (s->at_end) return false;
+
+    if (s->thread) {
+        SDL_SemPost(s->free_blocks);
+        SDL_SemWait(s->filled);
+        s->current = (s->current + 1) % STREAM_BLOCKS;
+    } else {
+        read_block(s, 0);
+    }
+
+    s->length = s->lengths[s->current];
+    s->pos = 0;
+    s->at_end = s->length < STREAM_BLOCK_SIZE;
+    return s->length > 0;
+}
+
+size_t read_save_stream(SaveStream* s, void* out, size_t size) {
+    uint8_t* dest = (uint8_t*)out;
+    size_t done = 0;
+
+    while (done < size) {
+        if (s->pos == s->length && !next_input_block(s)) break;
+
+        size_t count = s->length - s->pos;
+        if (count > size - done) count = size - done;
+        if (dest) memcpy(dest + done, s->blocks[s->current] + s->pos, count);
+        s->pos += count;
+        done += count;
+    }
+    return done;
+}
+
+void close_save_input(SaveStream* s) {
+    stop_input_helper(s);
+    free_stream(s);
+}
+
+bool save_stream_failed(SaveStream* s) {
+    return SDL_AtomicGet(&s->failed) != 0;
+}
+
+uint64_t get_save_stream_size(SaveStream* s) {
+    return s->bytes;
+}
+
+uint32_t get_save_stream_crc(SaveStream* s) {
+    return s->crc;
+}
@@ -0,0 +1,44 @@
+#ifndef SAVE_STREAM_H
+#define SAVE_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Bounded file streams for saves. Data passes through a small ring of
+// fixed-size blocks that a helper thread writes out (or reads ahead), so
+// the caller serialises or parses one block while the disk works on
+// another, and memory use does not grow with the size of the file.
+// Without a helper thread the blocks are written and read inline.
+
+#define STREAM_BLOCK_SIZE (256 * 1024)
+#define STREAM_BLOCKS 4
+
+typedef struct SaveStream SaveStream;
+
+// Output goes to path.tmp, which close_save_output renames over path once
+// everything is written and flushed to disk. commit false, or any earlier
+// write failure, removes the temporary and leaves path untouched.
+SaveStream* open_save_output(const char* path);
+bool write_save_stream(SaveStream* stream, const void* data, size_t size);
+bool close_save_output(SaveStream* stream, bool commit);
+
+// Returns the number of bytes read, short only at the end of the file or on
+// a read error (see save_stream_failed). out may be NULL to skip bytes.
+SaveStream* open_save_input(const char* path);
+size_t read_save_stream(SaveStream* stream, void* out, size_t size);
+void close_save_input(SaveStream* stream);
+
+// Start reading an input stream again from the beginning of the same open
+// file, with a fresh checksum
+bool rewind_save_input(SaveStream* stream);
+
+bool save_stream_failed(SaveStream* stream);
+
+// Bytes written to an output stream so far
+uint64_t get_save_stream_size(SaveStream* stream);
+
+// CRC32C of a whole input file, valid once reading has reached its end
+uint32_t get_save_stream_crc(SaveStream* stream);
+
+#endif // SAVE_STREAM_H
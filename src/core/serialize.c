@@ -0,0 +1,531 @@
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "serialize.h"
+#include "compress.h"
+#include "checksum.h"
+
+#define WRITER_INITIAL_CAPACITY 4096
+#define MIN_COMPRESSED_CHUNK 64         // Smaller bodies are always stored raw
+#define MAX_UNPACKED_CHUNK (256u << 20) // Sanity limit on a decompressed body
+
+void writer_init(SaveWriter* w) {
+    w->data = NULL;
+    w->size = 0;
+    w->capacity = 0;
+    w->ok = true;
+    w->compress_chunks = false;
+    w->sink = NULL;
+    w->sink_context = NULL;
+}
+
+void writer_free(SaveWriter* w) {
+    free(w->data);
+    writer_init(w);
+}
+
+void writer_set_sink(SaveWriter* w, bool (*sink)(void* context, const uint8_t* data, size_t size),
+                     void* context) {
+    w->sink = sink;
+    w->sink_context = context;
+}
+
+void writer_flush(SaveWriter* w) {
+    if (!w->sink || !w->ok) return;
+    if (w->size > 0 && !w->sink(w->sink_context, w->data, w->size)) {
+        w->ok = false;
+    }
+    w->size = 0;
+}
+
+static bool writer_reserve(SaveWriter* w, size_t extra) {
+    if (!w->ok) return false;
+    if (w->size + extra <= w->capacity) return true;
+
+    size_t capacity = w->capacity ? w->capacity : WRITER_INITIAL_CAPACITY;
+    while (capacity < w->size + extra) capacity *= 2;
+
+    uint8_t* data = (uint8_t*)realloc(w->data, capacity);
+    if (!data) {
+        w->ok = false;
+        return false;
+    }
+    w->data = data;
+    w->capacity = capacity;
+    return true;
+}
+
+void write_bytes(SaveWriter* w, const void* data, size_t size) {
+    if (!writer_reserve(w, size)) return;
+    memcpy(w->data + w->size, data, size);
+    w->size += size;
+}
+
+void write_u8(SaveWriter* w, uint8_t value) {
+    write_bytes(w, &value, 1);
+}
+
+void write_u16(SaveWriter* w, uint16_t value) {
+    uint8_t bytes[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+    write_bytes(w, bytes, 2);
+}
+
+void write_u32(SaveWriter* w, uint32_t value) {
+    uint8_t bytes[4] = { (uint8_t)value, (uint8_t)(value >> 8),
+                         (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    write_bytes(w, bytes, 4);
+}
+
+void write_i32(SaveWriter* w, int32_t value) {
+    write_u32(w, (uint32_t)value);
+}
+
+void write_i64(SaveWriter* w, int64_t value) {
+    write_u32(w, (uint32_t)(uint64_t)value);
+    write_u32(w, (uint32_t)((uint64_t)value >> 32));
+}
+
+void write_f32(SaveWriter* w, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write_u32(w, bits);
+}
+
+void write_string(SaveWriter* w, const char* text) {
+    size_t length = strlen(text);
+    if (length > 255) length = 255;
+    write_u8(w, (uint8_t)length);
+    write_bytes(w, text, length);
+}
+
+// Patch a little-endian value into already written output
+static void patch_u16(SaveWriter* w, size_t offset, uint16_t value) {
+    if (!w->ok) return;
+    w->data[offset] = (uint8_t)value;
+    w->data[offset + 1] = (uint8_t)(value >> 8);
+}
+
+static void patch_u32(SaveWriter* w, size_t offset, uint32_t value) {
+    if (!w->ok) return;
+    for (int i = 0; i < 4; i++) {
+        w->data[offset + i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+// CRC32C over a whole chunk as stored, skipping the checksum field itself
+static uint32_t chunk_checksum(const uint8_t* chunk, size_t size) {
+    uint32_t crc = crc32c(0, chunk, 12);
+    return crc32c(crc, chunk + CHUNK_HEADER_SIZE, size - CHUNK_HEADER_SIZE);
+}
+
+size_t begin_chunk(SaveWriter* w, uint32_t id, uint16_t version) {
+    size_t mark = w->size;
+    write_u32(w, id);
+    write_u16(w, version);
+    write_u16(w, 0);        // Flags
+    write_u32(w, 0);        // Length, patched by end_chunk
+    write_u32(w, 0);        // Checksum, patched by end_chunk
+    return mark;
+}
+
+// Replace a finished chunk body with its compressed form if that is smaller
+static void compress_chunk_body(SaveWriter* w, size_t mark) {
+    size_t body = mark + CHUNK_HEADER_SIZE;
+    size_t size = w->size - body;
+    if (size < MIN_COMPRESSED_CHUNK || size > MAX_UNPACKED_CHUNK) return;
+
+    size_t capacity = compress_bound(size);
+    uint8_t* packed = (uint8_t*)malloc(capacity);
+    if (!packed) return;    // Stored raw instead
+
+    size_t packed_size = compress_block(w->data + body, size, packed, capacity);
+    if (packed_size > 0 && packed_size + 4 < size) {
+        w->size = body;
+        write_u32(w, (uint32_t)size);
+        write_bytes(w, packed, packed_size);
+        patch_u16(w, mark + 6, CHUNK_FLAG_COMPRESSED);
+    }
+    free(packed);
+}
+
+void end_chunk(SaveWriter* w, size_t mark) {
+    if (w->compress_chunks && w->ok) compress_chunk_body(w, mark);
+    patch_u32(w, mark + 8, (uint32_t)(w->size - mark - CHUNK_HEADER_SIZE));
+    if (w->ok) patch_u32(w, mark + 12, chunk_checksum(w->data + mark, w->size - mark));
+}
+
+size_t begin_record(SaveWriter* w) {
+    size_t mark = w->size;
+    write_u16(w, 0);
+    return mark;
+}
+
+void end_record(SaveWriter* w, size_t mark) {
+    size_t length = w->size - mark - 2;
+    if (length > UINT16_MAX) {
+        w->ok = false;
+        return;
+    }
+    patch_u16(w, mark, (uint16_t)length);
+}
+
+void reader_init(SaveReader* r, const void* data, size_t size) {
+    r->data = (const uint8_t*)data;
+    r->size = size;
+    r->pos = 0;
+    r->ok = true;
+}
+
+// Returns the next size bytes, or NULL (clearing ok) if there are fewer
+static const uint8_t* reader_take(SaveReader* r, size_t size) {
+    if (!r->ok || r->size - r->pos < size) {
+        r->ok = false;
+        return NULL;
+    }
+    const uint8_t* p = r->data + r->pos;
+    r->pos += size;
+    return p;
+}
+
+void read_bytes(SaveReader* r, void* out, size_t size) {
+    const uint8_t* p = reader_take(r, size);
+    if (p) memcpy(out, p, size);
+    else memset(out, 0, size);
+}
+
+void skip_bytes(SaveReader* r, size_t size) {
+    reader_take(r, size);
+}
+
+uint8_t read_u8(SaveReader* r) {
+    const uint8_t* p = reader_take(r, 1);
+    return p ? p[0] : 0;
+}
+
+uint16_t read_u16(SaveReader* r) {
+    const uint8_t* p = reader_take(r, 2);
+    return p ? (uint16_t)(p[0] | (p[1] << 8)) : 0;
+}
+
+uint32_t read_u32(SaveReader* r) {
+    const uint8_t* p = reader_take(r, 4);
+    if (!p) return 0;
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int32_t read_i32(SaveReader* r) {
+    return (int32_t)read_u32(r);
+}
+
+int64_t read_i64(SaveReader* r) {
+    uint64_t low = read_u32(r);
+    uint64_t high = read_u32(r);
+    return (int64_t)(low | (high << 32));
+}
+
+float read_f32(SaveReader* r) {
+    uint32_t bits = read_u32(r);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void read_string(SaveReader* r, char* out, size_t out_size) {
+    size_t length = read_u8(r);
+    const uint8_t* p = reader_take(r, length);
+    if (!p) length = 0;
+
+    size_t copy = length < out_size - 1 ? length : out_size - 1;
+    if (copy) memcpy(out, p, copy);
+    out[copy] = '\0';
+}
+
+bool read_chunk(SaveReader* r, SaveChunk* chunk) {
+    if (!r->ok || r->pos == r->size) return false;
+
+    const uint8_t* start = r->data + r->pos;
+    chunk->id = read_u32(r);
+    chunk->version = read_u16(r);
+    chunk->flags = read_u16(r);
+    uint32_t length = read_u32(r);
+    uint32_t checksum = read_u32(r);
+
+    const uint8_t* body = reader_take(r, length);
+    if (!body) return false;
+    reader_init(&chunk->body, body, length);
+    chunk->intact = chunk_checksum(start, CHUNK_HEADER_SIZE + (size_t)length) == checksum;
+    return true;
+}
+
+bool unpack_chunk(SaveChunk* chunk, uint8_t** storage) {
+    *storage = NULL;
+    if (!(chunk->flags & CHUNK_FLAG_COMPRESSED)) return true;
+
+    uint32_t size = read_u32(&chunk->body);
+    if (!chunk->body.ok || size > MAX_UNPACKED_CHUNK) return false;
+
+    uint8_t* data = (uint8_t*)malloc(size > 0 ? size : 1);
+    if (!data) return false;
+
+    const uint8_t* packed = chunk->body.data + chunk->body.pos;
+    if (!decompress_block(packed, chunk->body.size - chunk->body.pos, data, size)) {
+        free(data);
+        return false;
+    }
+
+    reader_init(&chunk->body, data, size);
+    chunk->flags &= (uint16_t)~CHUNK_FLAG_COMPRESSED;
+    *storage = data;
+    return true;
+}
+
+bool read_record(SaveReader* r, SaveReader* record) {
+    uint16_t length = read_u16(r);
+    const uint8_t* body = reader_take(r, length);
+    if (!body) return false;
+    reader_init(record, body, length);
+    return true;
+}
+
+// Integer members of 1, 2 or 4 bytes, whatever their type in the struct
+static uint32_t load_member(const uint8_t* member, uint16_t size) {
+    if (size == 1) return member[0];
+    if (size == 2) {
+        uint16_t value;
+        memcpy(&value, member, 2);
+        return value;
+    }
+    uint32_t value;
+    memcpy(&value, member, 4);
+    return value;
+}
+
+static void store_member(uint8_t* member, uint16_t size, uint32_t value) {
+    if (size == 1) {
+        member[0] = (uint8_t)value;
+    } else if (size == 2) {
+        uint16_t narrow = (uint16_t)value;
+        memcpy(member, &narrow, 2);
+    } else {
+        memcpy(member, &value, 4);
+    }
+}
+
+void write_fields(SaveWriter* w, const void* object, const FieldDesc* fields, int count) {
+    const uint8_t* base = (const uint8_t*)object;
+
+    for (int i = 0; i < count; i++) {
+        const FieldDesc* field = &fields[i];
+        const uint8_t* member = base + field->offset;
+
+        switch (field->type) {
+            case FIELD_U8:
+                write_u8(w, (uint8_t)load_member(member, field->size));
+                break;
+            case FIELD_BOOL:
+                write_u8(w, load_member(member, field->size) != 0);
+                break;
+            case FIELD_U16:
+                write_u16(w, (uint16_t)load_member(member, field->size));
+                break;
+            case FIELD_U32:
+            case FIELD_I32:
+                write_u32(w, load_member(member, field->size));
+                break;
+            case FIELD_F32: {
+                float value;
+                memcpy(&value, member, sizeof(value));
+                write_f32(w, value);
+                break;
+            }
+            case FIELD_STRING:
+                write_string(w, (const char*)member);
+                break;
+        }
+    }
+}
+
+void read_fields(SaveReader* record, void* object, const FieldDesc* fields, int count) {
+    uint8_t* base = (uint8_t*)object;
+
+    for (int i = 0; i < count; i++) {
+        if (record->ok && record->pos == record->size) return;   // Older, shorter record
+
+        const FieldDesc* field = &fields[i];
+        uint8_t* member = base + field->offset;
+
+        switch (field->type) {
+            case FIELD_U8:
+                store_member(member, field->size, read_u8(record));
+                break;
+            case FIELD_BOOL:
+                store_member(member, field->size, read_u8(record) != 0);
+                break;
+            case FIELD_U16:
+                store_member(member, field->size, read_u16(record));
+                break;
+            case FIELD_U32:
+            case FIELD_I32:
+                store_member(member, field->size, read_u32(record));
+                break;
+            case FIELD_F32: {
+                float value = read_f32(record);
+                memcpy(member, &value, sizeof(value));
+                break;
+            }
+            case FIELD_STRING:
+                read_string(record, (char*)member, field->size);
+                break;
+        }
+    }
+}
+
+bool check_fields(SaveReader* record, const FieldDesc* fields, int count) {
+    for (int i = 0; i < count; i++) {
+        if (record->ok && record->pos == record->size) break;   // Older, shorter record
+
+        switch (fields[i].type) {
+            case FIELD_U8:
+            case FIELD_BOOL:
+                skip_bytes(record, 1);
+                break;
+            case FIELD_U16:
+                skip_bytes(record, 2);
+                break;
+            case FIELD_U32:
+            case FIELD_I32:
+            case FIELD_F32:
+                skip_bytes(record, 4);
+                break;
+            case FIELD_STRING:
+                skip_bytes(record, read_u8(record));
+                break;
+        }
+    }
+    return record->ok;
+}
+
+static uint8_t* store_item(const RecordStore* store, uint32_t index) {
+    return (uint8_t*)store->items + (size_t)index * store->item_size;
+}
+
+static bool is_item_active(const RecordStore* store, uint32_t index) {
+    return store->active_offset < 0 || *(const bool*)(store_item(store, index) + store->active_offset);
+}
+
+static uint32_t count_active_items(const RecordStore* store) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < (uint32_t)*store->used; i++) {
+        if (is_item_active(store, i)) count++;
+    }
+    return count;
+}
+
+void save_records_header(SaveWriter* w, const RecordStore* store) {
+    if (store->keep_slots) write_u32(w, (uint32_t)*store->used);
+    write_u32(w, count_active_items(store));
+}
+
+int count_record_batches(const RecordStore* store) {
+    return (int)((count_active_items(store) + RECORD_BATCH_SIZE - 1) / RECORD_BATCH_SIZE);
+}
+
+// Write the next RECORD_BATCH_SIZE live items at or after cursor and
+// return where the next batch starts
+int save_record_batch(SaveWriter* w, const RecordStore* store, int cursor) {
+    int used = *store->used;
+    int end = cursor;
+    uint32_t count = 0;
+    while (end < used && count < RECORD_BATCH_SIZE) {
+        if (is_item_active(store, (uint32_t)end)) count++;
+        end++;
+    }
+
+    write_u32(w, count);
+    for (int i = cursor; i < end; i++) {
+        if (!is_item_active(store, (uint32_t)i)) continue;
+
+        size_t record = begin_record(w);
+        if (store->keep_slots) write_u16(w, (uint16_t)i);
+        write_fields(w, store_item(store, (uint32_t)i), store->fields, store->num_fields);
+        end_record(w, record);
+    }
+    return end;
+}
+
+static bool read_records_header(SaveReader* r, const RecordStore* store, RecordCursor* cursor) {
+    cursor->store = store;
+    cursor->slots = store->keep_slots ? read_u32(r) : 0;
+    cursor->count = read_u32(r);
+    cursor->done = 0;
+    if (!store->keep_slots) cursor->slots = cursor->count;
+    return r->ok && cursor->slots <= store->capacity && cursor->count <= cursor->slots;
+}
+
+// Read the next count records, into the store if load is set
+static bool read_record_list(SaveReader* r, RecordCursor* cursor, uint32_t count, bool load) {
+    const RecordStore* store = cursor->store;
+    if (count > cursor->count - cursor->done) return false;
+
+    for (uint32_t n = 0; n < count; n++) {
+        SaveReader record;
+        if (!read_record(r, &record)) return false;
+
+        uint32_t slot = store->keep_slots ? read_u16(&record) : cursor->done;
+        if (!record.ok || slot >= cursor->slots) return false;
+        cursor->done++;
+
+        if (load) {
+            uint8_t* item = store_item(store, slot);
+            if (store->active_offset >= 0) *(bool*)(item + store->active_offset) = true;
+            read_fields(&record, item, store->fields, store->num_fields);
+        } else {
+            check_fields(&record, store->fields, store->num_fields);
+        }
+        if (!record.ok) return false;
+    }
+    return true;
+}
+
+bool check_records(SaveReader* r, uint16_t version, const RecordStore* store, RecordCursor* cursor) {
+    if (!read_records_header(r, store, cursor)) return false;
+    return version >= 2 || read_record_list(r, cursor, cursor->count, false);
+}
+
+bool load_records(SaveReader* r, uint16_t version, const RecordStore* store, RecordCursor* cursor) {
+    if (!read_records_header(r, store, cursor)) return false;
+
+    memset(store->items, 0, (size_t)store->capacity * store->item_size);
+    *store->used = (int)cursor->slots;
+    if (store->generation) (*store->generation)++;
+    return version >= 2 || read_record_list(r, cursor, cursor->count, true);
+}
+
+bool check_record_batch(SaveReader* r, RecordCursor* cursor) {
+    uint32_t count = read_u32(r);
+    return r->ok && read_record_list(r, cursor, count, false);
+}
+
+bool load_record_batch(SaveReader* r, RecordCursor* cursor) {
+    uint32_t count = read_u32(r);
+    return r->ok && read_record_list(r, cursor, count, true);
+}
+
+void write_f32_column(SaveWriter* w, const float* values, size_t count) {
+    #if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    write_bytes(w, values, count * sizeof(float));
+    #else
+    for (size_t i = 0; i < count; i++) write_f32(w, values[i]);
+    #endif
+}
+
+void read_f32_column(SaveReader* r, float* values, size_t count) {
+    #if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    read_bytes(r, values, count * sizeof(float));
+    #else
+    for (size_t i = 0; i < count; i++) values[i] = read_f32(r);
+    #endif
+}
@@ -0,0 +1,198 @@
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Explicit-width, little-endian serialisation to and from memory buffers,
+// plus the tagged chunk framing used by save files:
+//
+//   chunk  := id (u32 FourCC) | version (u16) | flags (u16) | length (u32) |
+//             checksum (u32) | body
+//   record := length (u16) | fields
+//
+// The checksum is a CRC32C of the header fields before it and the body as
+// stored (compressed or not), so damage anywhere in a chunk is caught
+// before any of it is parsed.
+//
+// Readers skip chunks they do not recognise, and fields are only ever
+// appended to a record, so a reader ignores whatever trails the fields it
+// knows. Together these let newer saves load in older builds.
+
+#define CHUNK_ID(a, b, c, d) \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+#define CHUNK_HEADER_SIZE 16
+
+// Chunk flags
+#define CHUNK_FLAG_COMPRESSED 0x0001    // Body is raw size (u32) + compress_block() output
+
+// Growable output buffer. Any failed allocation clears ok and later writes
+// are dropped, so callers only need to check ok once at the end.
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    bool ok;
+    bool compress_chunks;   // end_chunk compresses bodies that shrink
+    bool (*sink)(void* context, const uint8_t* data, size_t size);
+    void* sink_context;
+} SaveWriter;
+
+void writer_init(SaveWriter* w);
+void writer_free(SaveWriter* w);
+
+// Streamed output: writer_flush() hands everything buffered to sink and
+// empties the buffer, so a writer flushed after each chunk only ever holds
+// one chunk. Flush between chunks only, as end_chunk patches the header of
+// the chunk it closes. A failed sink clears ok. Without a sink, writer_flush
+// does nothing and the buffer holds all the output.
+void writer_set_sink(SaveWriter* w, bool (*sink)(void* context, const uint8_t* data, size_t size),
+                     void* context);
+void writer_flush(SaveWriter* w);
+
+void write_bytes(SaveWriter* w, const void* data, size_t size);
+void write_u8(SaveWriter* w, uint8_t value);
+void write_u16(SaveWriter* w, uint16_t value);
+void write_u32(SaveWriter* w, uint32_t value);
+void write_i32(SaveWriter* w, int32_t value);
+void write_i64(SaveWriter* w, int64_t value);
+void write_f32(SaveWriter* w, float value);
+void write_string(SaveWriter* w, const char* text);    // u8 length + bytes
+
+// Returns a mark to pass to the matching end_* once the body is written
+size_t begin_chunk(SaveWriter* w, uint32_t id, uint16_t version);
+void end_chunk(SaveWriter* w, size_t mark);
+size_t begin_record(SaveWriter* w);
+void end_record(SaveWriter* w, size_t mark);
+
+// Bounds-checked input cursor. Reading past the end clears ok and returns
+// zeros, so as with the writer a single ok check after a batch is enough.
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+    bool ok;
+} SaveReader;
+
+void reader_init(SaveReader* r, const void* data, size_t size);
+
+void read_bytes(SaveReader* r, void* out, size_t size);
+void skip_bytes(SaveReader* r, size_t size);
+uint8_t read_u8(SaveReader* r);
+uint16_t read_u16(SaveReader* r);
+uint32_t read_u32(SaveReader* r);
+int32_t read_i32(SaveReader* r);
+int64_t read_i64(SaveReader* r);
+float read_f32(SaveReader* r);
+void read_string(SaveReader* r, char* out, size_t out_size);
+
+typedef struct {
+    uint32_t id;
+    uint16_t version;
+    uint16_t flags;
+    bool intact;            // Checksum matches the header and body
+    SaveReader body;
+} SaveChunk;
+
+// Read the next chunk header, point chunk->body at its contents and verify
+// its checksum. Returns false at the end of the data or on a truncated
+// chunk (r->ok is cleared only in the second case).
+bool read_chunk(SaveReader* r, SaveChunk* chunk);
+
+// If the chunk is compressed, decompress its body into a new buffer that the
+// caller frees after use (*storage is NULL otherwise). False on corrupt data.
+bool unpack_chunk(SaveChunk* chunk, uint8_t** storage);
+
+// Point record at the next length-prefixed record and step over it
+bool read_record(SaveReader* r, SaveReader* record);
+
+// Table-driven records. A FieldDesc names one struct member and how it is
+// stored; write_fields and read_fields walk the same table, so save and
+// load cannot drift apart and a struct change only touches its table.
+// Integer members may be any width in memory (bool, enum, int): they are
+// widened or narrowed to the stored width, never copied as raw memory.
+typedef enum {
+    FIELD_U8,
+    FIELD_BOOL,         // u8, 0 or 1
+    FIELD_U16,
+    FIELD_U32,
+    FIELD_I32,
+    FIELD_F32,
+    FIELD_STRING        // char array, stored as by write_string()
+} FieldType;
+
+typedef struct {
+    FieldType type;
+    uint16_t offset;
+    uint16_t size;      // Size of the member in memory
+} FieldDesc;
+
+#define FIELD(type, struct_type, member) \
+    { type, (uint16_t)offsetof(struct_type, member), (uint16_t)sizeof(((struct_type*)0)->member) }
+#define NUM_FIELDS(table) (int)(sizeof(table) / sizeof((table)[0]))
+
+void write_fields(SaveWriter* w, const void* object, const FieldDesc* fields, int count);
+
+// Read a record written from the same table. A record from an older build
+// that ends before the table does leaves the missing members as they were,
+// so new fields appended to a table need no version check.
+void read_fields(SaveReader* record, void* object, const FieldDesc* fields, int count);
+
+// Step over a record's fields as read_fields would read them, storing
+// nothing. False if the record is cut short part way through a field.
+bool check_fields(SaveReader* record, const FieldDesc* fields, int count);
+
+// Table-driven entity stores. A RecordStore describes a fixed array of
+// records, so one set of functions saves, checks and loads every store.
+// A store's chunk holds only its header; the records follow in batch
+// chunks of up to RECORD_BATCH_SIZE each, so no chunk grows with the store
+// (version 1 chunks carried every record inline after the header):
+//
+//   header := [slots (u32)] | count (u32)
+//   batch  := count (u32) | record*
+//
+// Stores whose items are referred to by index keep each item in its slot:
+// slots is saved and every record starts with its slot (u16). The others
+// are saved packed and loaded into [0, count).
+#define RECORD_BATCH_SIZE 256
+
+typedef struct {
+    void* items;
+    size_t item_size;
+    uint32_t capacity;
+    int* used;              // Every live item is below *used
+    int active_offset;      // Offset of the item's bool active flag, -1 if all below *used live
+    bool keep_slots;
+    const FieldDesc* fields;
+    int num_fields;
+    uint32_t* generation;   // Bumped whenever the store is loaded, or NULL
+} RecordStore;
+
+// Progress through a store's records as its batches are read
+typedef struct {
+    const RecordStore* store;
+    uint32_t slots;
+    uint32_t count;         // Records the header promises
+    uint32_t done;          // Records read so far
+} RecordCursor;
+
+void save_records_header(SaveWriter* w, const RecordStore* store);
+int count_record_batches(const RecordStore* store);
+int save_record_batch(SaveWriter* w, const RecordStore* store, int cursor);  // Returns the next batch's cursor
+
+// The check functions read a store through without touching it. The load
+// functions replace its contents, starting with the header, and cannot fail
+// on data that checked out. The store is whole once cursor->done reaches
+// cursor->count.
+bool check_records(SaveReader* r, uint16_t version, const RecordStore* store, RecordCursor* cursor);
+bool load_records(SaveReader* r, uint16_t version, const RecordStore* store, RecordCursor* cursor);
+bool check_record_batch(SaveReader* r, RecordCursor* cursor);
+bool load_record_batch(SaveReader* r, RecordCursor* cursor);
+
+// One column of a structure-of-arrays store: count consecutive little-endian
+// values. On little-endian hosts each direction is a single copy.
+void write_f32_column(SaveWriter* w, const float* values, size_t count);
+void read_f32_column(SaveReader* r, float* values, size_t count);
+
+#endif // SERIALIZE_H
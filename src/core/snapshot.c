@@ -0,0 +1,45 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "snapshot.h"
+
+// Triple buffer: the writer owns one buffer, the reader owns another and the
+// third sits in the middle. Publishing and acquiring each swap the owned
+// buffer with the middle one in a single atomic exchange.
+
+#define SNAPSHOT_INDEX_MASK 0x3
+#define SNAPSHOT_FRESH 0x4      // Middle buffer holds a snapshot the reader hasn't seen
+
+static SimSnapshot g_snapshots[3];
+static SDL_atomic_t g_middle;
+static int g_write_index = 0;   // Only touched by the writer
+static int g_read_index = 1;    // Only touched by the reader
+
+void init_snapshots(void) {
+    memset(g_snapshots, 0, sizeof(g_snapshots));
+    g_write_index = 0;
+    g_read_index = 1;
+    SDL_AtomicSet(&g_middle, 2);
+}
+
+SimSnapshot* begin_snapshot(void) {
+    return &g_snapshots[g_write_index];
+}
+
+void publish_snapshot(void) {
+    int old = SDL_AtomicSet(&g_middle, g_write_index | SNAPSHOT_FRESH);
+    g_write_index = old & SNAPSHOT_INDEX_MASK;
+}
+
+const SimSnapshot* acquire_snapshot(void) {
+    if (SDL_AtomicGet(&g_middle) & SNAPSHOT_FRESH) {
+        int old = SDL_AtomicSet(&g_middle, g_read_index);
+        g_read_index = old & SNAPSHOT_INDEX_MASK;
+    }
+    return &g_snapshots[g_read_index];
+}
+
+const SimSnapshot* get_current_snapshot(void) {
+    return &g_snapshots[g_read_index];
+}
@@ -0,0 +1,107 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Immutable copy of everything the renderer and UI read from the simulation.
+// The simulation thread fills the back buffer at the end of each tick and
+// publishes it; the render thread picks up the newest one without locking.
+
+#define SNAPSHOT_MAX_GUESTS 100
+#define SNAPSHOT_MAX_STAFF 20
+#define SNAPSHOT_MAX_RIDES 50
+#define SNAPSHOT_MAX_SHOPS 50
+#define SNAPSHOT_MAX_SCENERY 500
+#define SNAPSHOT_MAX_LITTER 200
+#define SNAPSHOT_MAX_PARTICLES 32768   // Per particle kind; matches the weather pools
+
+typedef struct {
+    float x, y;
+    uint32_t color;
+} SnapshotGuest;
+
+typedef struct {
+    float x, y;
+    int type;
+} SnapshotStaff;
+
+typedef struct {
+    bool active;
+    int x, y;
+    int width, height;
+    int status;
+    int queue_length;
+    char name[32];
+} SnapshotRide;
+
+typedef struct {
+    int x, y;
+    int type;
+} SnapshotShop;
+
+typedef struct {
+    int x, y;
+    int type;
+    uint32_t color;
+} SnapshotScenery;
+
+typedef struct {
+    float x, y;
+} SnapshotLitter;
+
+// Weather particles of one kind, one packed column per attribute
+typedef struct {
+    int count;
+    float x[SNAPSHOT_MAX_PARTICLES];
+    float y[SNAPSHOT_MAX_PARTICLES];
+    float size[SNAPSHOT_MAX_PARTICLES];
+} SnapshotParticles;
+
+typedef struct {
+    uint32_t tick;
+
+    // Park stats
+    int park_rating;
+    int park_money;
+    int total_guests_entered;
+    float time_of_day;
+
+    // Weather
+    const char* weather_name;
+    uint32_t weather_sky_tint;
+    float weather_intensity;
+    float weather_visibility;
+
+    // Bumped by the owning modules when their layout changes
+    uint32_t scenery_generation;
+    uint32_t rides_generation;
+
+    int num_guests;
+    SnapshotGuest guests[SNAPSHOT_MAX_GUESTS];
+    int num_staff;
+    SnapshotStaff staff[SNAPSHOT_MAX_STAFF];
+    int num_rides;
+    SnapshotRide rides[SNAPSHOT_MAX_RIDES];
+    int num_shops;
+    SnapshotShop shops[SNAPSHOT_MAX_SHOPS];
+    int num_scenery;
+    SnapshotScenery scenery[SNAPSHOT_MAX_SCENERY];
+    int num_litter;
+    SnapshotLitter litter[SNAPSHOT_MAX_LITTER];
+    SnapshotParticles rain;
+    SnapshotParticles snow;
+} SimSnapshot;
+
+// Triple buffer lifetime
+void init_snapshots(void);
+
+// Writer side (simulation thread): fill the back buffer, then publish it
+SimSnapshot* begin_snapshot(void);
+void publish_snapshot(void);
+
+// Reader side (render thread): swap in the newest published snapshot, if any
+const SimSnapshot* acquire_snapshot(void);
+const SimSnapshot* get_current_snapshot(void);
+
+#endif // SNAPSHOT_H
@@ -2,8 +2,13 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+#include <stddef.h>
 #include <math.h>
 
+#include "../core/snapshot.h"
+#include "../core/serialize.h"
+
 #define MAX_LITTER 200
 
 typedef struct {
@@ -95,6 +100,18 @@ void get_litter_position(int idx, float* x, float* y) {
     }
 }
 
+// Copy active litter for the renderer
+void write_litter_snapshot(SimSnapshot* snap) {
+    int count = 0;
+    for (int i = 0; i < g_num_litter && count < SNAPSHOT_MAX_LITTER; i++) {
+        if (!g_litter[i].active) continue;
+        snap->litter[count].x = g_litter[i].x;
+        snap->litter[count].y = g_litter[i].y;
+        count++;
+    }
+    snap->num_litter = count;
+}
+
 // Find nearest litter for janitor
 bool find_nearest_litter(float from_x, float from_y, float* target_x, float* target_y) {
     float nearest_dist = 999999.0f;
@@ -122,13 +139,19 @@ int get_total_litter_count(void) {
     return get_num_litter();
 }
 
-// Save/Load support
-void save_litter_data(FILE* f) {
-    fwrite(&g_num_litter, sizeof(int), 1, f);
-    fwrite(g_litter, sizeof(Litter), MAX_LITTER, f);
-}
-
-void load_litter_data(FILE* f) {
-    fread(&g_num_litter, sizeof(int), 1, f);
-    fread(g_litter, sizeof(Litter), MAX_LITTER, f);
+// Save/Load support; fields are only ever appended to this table
+static const FieldDesc g_litter_fields[] = {
+    FIELD(FIELD_F32, Litter, x),
+    FIELD(FIELD_F32, Litter, y),
+    FIELD(FIELD_F32, Litter, age),
+};
+
+// Nothing refers to litter by index, so it is compacted on save
+static const RecordStore g_litter_store = {
+    g_litter, sizeof(Litter), MAX_LITTER, &g_num_litter, (int)offsetof(Litter, active), false,
+    g_litter_fields, NUM_FIELDS(g_litter_fields), NULL
+};
+
+const RecordStore* get_litter_store(void) {
+    return &g_litter_store;
 }
@@ -0,0 +1,426 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "map.h"
+
+typedef struct {
+    uint8_t height;
+    uint8_t type;  // 0=grass, 1=path, 2=ride
+} Tile;
+
+// Saves store chunk tiles as (height, type) byte pairs, which is exactly
+// this layout, so they are written and read with one copy per chunk
+_Static_assert(sizeof(Tile) == 2, "Tile must stay two packed bytes");
+
+typedef struct {
+    Tile* tiles;        // CHUNK_SIZE * CHUNK_SIZE, NULL while untouched
+    uint32_t generation;    // g_map_generation at the chunk's last edit
+    uint8_t max_height;
+} MapChunk;
+
+typedef struct {
+    int width, height;
+    int chunks_x, chunks_y;
+    MapChunk* chunks;
+} TileMap;
+
+static TileMap g_map = {0};
+
+// Bumped on every tile edit and never reset, so a saved generation tells
+// which chunks changed since (see save_map_delta)
+static uint32_t g_map_generation = 0;
+
+static void free_tile_map(TileMap* map) {
+    if (map->chunks) {
+        for (int i = 0; i < map->chunks_x * map->chunks_y; i++) {
+            free(map->chunks[i].tiles);
+        }
+        free(map->chunks);
+    }
+    memset(map, 0, sizeof(*map));
+}
+
+static bool init_tile_map(TileMap* map, int width, int height) {
+    if (width <= 0 || height <= 0 || width > MAX_MAP_SIZE || height > MAX_MAP_SIZE) {
+        printf("Invalid map size: %dx%d\n", width, height);
+        return false;
+    }
+
+    free_tile_map(map);
+
+    map->width = width;
+    map->height = height;
+    map->chunks_x = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    map->chunks_y = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    int num_chunks = map->chunks_x * map->chunks_y;
+    map->chunks = (MapChunk*)calloc(num_chunks, sizeof(MapChunk));
+    if (!map->chunks) {
+        printf("Map allocation failed\n");
+        free_tile_map(map);
+        return false;
+    }
+
+    return true;
+}
+
+// Create an empty (flat grass) map
+bool create_map(int width, int height) {
+    return init_tile_map(&g_map, width, height);
+}
+
+// Create the default test park terrain
+void init_map(void) {
+    printf("Initializing map...\n");
+
+    if (!create_map(DEFAULT_MAP_SIZE, DEFAULT_MAP_SIZE)) {
+        return;
+    }
+
+    for (int y = 0; y < DEFAULT_MAP_SIZE; y++) {
+        for (int x = 0; x < DEFAULT_MAP_SIZE; x++) {
+            // Create a winding path
+            if ((x == 5 && y >= 5 && y <= 25) || 
+                (y == 25 && x >= 5 && x <= 15) ||
+                (x == 15 && y >= 10 && y <= 25) ||
+                (y == 10 && x >= 15 && x <= 25)) {
+                set_tile_type(x, y, 1); // path
+            }
+            
+            // Create some hills
+            int dx = x - 20;
+            int dy = y - 20;
+            float dist = sqrtf(dx*dx + dy*dy);
+            if (dist < 5) {
+                set_tile_height(x, y, (int)(3 - dist * 0.6f));
+            }
+            
+            // Create a flat area for rides
+            if (x >= 8 && x <= 12 && y >= 8 && y <= 12) {
+                set_tile_height(x, y, 0);
+                if (x == 10 && y == 10) {
+                    set_tile_type(x, y, 2); // ride
+                }
+            }
+        }
+    }
+}
+
+int get_map_width(void) {
+    return g_map.width;
+}
+
+int get_map_height(void) {
+    return g_map.height;
+}
+
+int get_map_chunks_x(void) {
+    return g_map.chunks_x;
+}
+
+int get_map_chunks_y(void) {
+    return g_map.chunks_y;
+}
+
+static MapChunk* get_chunk(int cx, int cy) {
+    if (cx < 0 || cx >= g_map.chunks_x || cy < 0 || cy >= g_map.chunks_y) {
+        return NULL;
+    }
+    return &g_map.chunks[cy * g_map.chunks_x + cx];
+}
+
+static const Tile* get_tile(int x, int y) {
+    if (x < 0 || x >= g_map.width || y < 0 || y >= g_map.height) {
+        return NULL;
+    }
+    MapChunk* chunk = &g_map.chunks[(y / CHUNK_SIZE) * g_map.chunks_x + (x / CHUNK_SIZE)];
+    if (!chunk->tiles) {
+        return NULL;
+    }
+    return &chunk->tiles[(y % CHUNK_SIZE) * CHUNK_SIZE + (x % CHUNK_SIZE)];
+}
+
+// Get a tile for writing, allocating its chunk on first touch
+static Tile* touch_tile(int x, int y) {
+    if (x < 0 || x >= g_map.width || y < 0 || y >= g_map.height) {
+        return NULL;
+    }
+    MapChunk* chunk = &g_map.chunks[(y / CHUNK_SIZE) * g_map.chunks_x + (x / CHUNK_SIZE)];
+    if (!chunk->tiles) {
+        chunk->tiles = (Tile*)calloc(CHUNK_SIZE * CHUNK_SIZE, sizeof(Tile));
+        if (!chunk->tiles) {
+            printf("Map chunk allocation failed\n");
+            return NULL;
+        }
+    }
+    chunk->generation = ++g_map_generation;
+    return &chunk->tiles[(y % CHUNK_SIZE) * CHUNK_SIZE + (x % CHUNK_SIZE)];
+}
+
+int get_tile_height(int x, int y) {
+    const Tile* tile = get_tile(x, y);
+    return tile ? tile->height : 0;
+}
+
+int get_tile_type(int x, int y) {
+    const Tile* tile = get_tile(x, y);
+    return tile ? tile->type : 0;
+}
+
+// Modify terrain
+void set_tile_height(int x, int y, int height) {
+    if (height == 0 && !get_tile(x, y)) return;  // Already flat grass
+
+    Tile* tile = touch_tile(x, y);
+    if (tile) {
+        tile->height = height;
+
+        MapChunk* chunk = get_chunk(x / CHUNK_SIZE, y / CHUNK_SIZE);
+        if (tile->height > chunk->max_height) chunk->max_height = tile->height;
+    }
+}
+
+void set_tile_type(int x, int y, int type) {
+    if (type == 0 && !get_tile(x, y)) return;  // Already grass
+
+    Tile* tile = touch_tile(x, y);
+    if (tile) {
+        tile->type = type;
+    }
+}
+
+bool is_map_chunk_allocated(int cx, int cy) {
+    MapChunk* chunk = get_chunk(cx, cy);
+    return chunk && chunk->tiles;
+}
+
+// Upper bound on tile height within a chunk (for visibility culling)
+int get_map_chunk_max_height(int cx, int cy) {
+    MapChunk* chunk = get_chunk(cx, cy);
+    return chunk ? chunk->max_height : 0;
+}
+
+static int count_stored_chunks(void) {
+    int num_chunks = g_map.chunks_x * g_map.chunks_y;
+    int stored = 0;
+    for (int i = 0; i < num_chunks; i++) {
+        if (g_map.chunks[i].tiles) stored++;
+    }
+    return stored;
+}
+
+// Save/Load map data: dimensions and the number of stored chunks. The
+// chunks themselves follow in batches (save_map_batch), so a save never
+// buffers more than a batch of tiles however large the map is.
+void save_map_data(SaveWriter* w) {
+    write_i32(w, g_map.width);
+    write_i32(w, g_map.height);
+    write_u32(w, (uint32_t)count_stored_chunks());
+}
+
+int count_map_batches(void) {
+    return (count_stored_chunks() + MAP_BATCH_CHUNKS - 1) / MAP_BATCH_CHUNKS;
+}
+
+// Write the next MAP_BATCH_CHUNKS stored chunks at or after cursor, in the
+// same layout as a delta, and return where the next batch starts.
+// Untouched chunks are flat grass and are not stored.
+int save_map_batch(SaveWriter* w, int cursor) {
+    int num_chunks = g_map.chunks_x * g_map.chunks_y;
+    int end = cursor;
+    int count = 0;
+    while (end < num_chunks && count < MAP_BATCH_CHUNKS) {
+        if (g_map.chunks[end].tiles) count++;
+        end++;
+    }
+
+    write_i32(w, g_map.width);
+    write_i32(w, g_map.height);
+    write_u32(w, (uint32_t)count);
+
+    for (int i = cursor; i < end; i++) {
+        const Tile* tiles = g_map.chunks[i].tiles;
+        if (!tiles) continue;
+
+        write_u32(w, (uint32_t)i);
+        write_bytes(w, tiles, CHUNK_SIZE * CHUNK_SIZE * sizeof(Tile));
+    }
+    return end;
+}
+
+// Read one chunk's tiles, allocating them if the chunk had none yet
+static bool read_chunk_tiles(SaveReader* r, MapChunk* chunk) {
+    if (!chunk->tiles) {
+        chunk->tiles = (Tile*)malloc(CHUNK_SIZE * CHUNK_SIZE * sizeof(Tile));
+        if (!chunk->tiles) {
+            printf("Map chunk allocation failed\n");
+            return false;
+        }
+    }
+
+    read_bytes(r, chunk->tiles, CHUNK_SIZE * CHUNK_SIZE * sizeof(Tile));
+    if (!r->ok) return false;
+
+    // Branch-free so the compiler can vectorise it
+    uint8_t max_height = 0;
+    for (int t = 0; t < CHUNK_SIZE * CHUNK_SIZE; t++) {
+        uint8_t height = chunk->tiles[t].height;
+        max_height = height > max_height ? height : max_height;
+    }
+    chunk->max_height = max_height;
+    return true;
+}
+
+static bool is_valid_map_size(int width, int height) {
+    return width > 0 && height > 0 && width <= MAX_MAP_SIZE && height <= MAX_MAP_SIZE;
+}
+
+static uint32_t count_map_chunks(int width, int height) {
+    return (uint32_t)(((width + CHUNK_SIZE - 1) / CHUNK_SIZE) * ((height + CHUNK_SIZE - 1) / CHUNK_SIZE));
+}
+
+// Read count (index, tiles) pairs through without keeping them. Chunks in
+// a save may not repeat; seen is NULL where repeats are allowed.
+static bool check_chunk_list(SaveReader* r, uint32_t num_chunks, uint32_t count, uint8_t* seen) {
+    if (count > num_chunks) return false;
+
+    for (uint32_t n = 0; n < count; n++) {
+        uint32_t index = read_u32(r);
+        if (!r->ok || index >= num_chunks) return false;
+        if (seen) {
+            if (seen[index]) return false;
+            seen[index] = 1;
+        }
+        skip_bytes(r, CHUNK_SIZE * CHUNK_SIZE * sizeof(Tile));
+    }
+    return r->ok;
+}
+
+static bool read_map_header(SaveReader* r, MapCursor* cursor) {
+    cursor->width = read_i32(r);
+    cursor->height = read_i32(r);
+    cursor->stored = read_u32(r);
+    cursor->done = 0;
+    return r->ok && is_valid_map_size(cursor->width, cursor->height) &&
+           cursor->stored <= count_map_chunks(cursor->width, cursor->height);
+}
+
+// Read a map chunk through without touching the map. Version 1 stored
+// every chunk inline; version 2 leaves them to the batches.
+bool check_map_data(SaveReader* r, uint16_t version, MapCursor* cursor) {
+    memset(cursor->seen, 0, sizeof(cursor->seen));
+    if (!read_map_header(r, cursor)) return false;
+    if (version >= 2) return true;
+
+    uint32_t num_chunks = count_map_chunks(cursor->width, cursor->height);
+    if (!check_chunk_list(r, num_chunks, cursor->stored, cursor->seen)) return false;
+    cursor->done = cursor->stored;
+    return true;
+}
+
+// Replace the map with a flat one of the saved size, and with the chunks
+// stored inline in a version 1 chunk
+bool load_map_data(SaveReader* r, uint16_t version, MapCursor* cursor) {
+    if (!read_map_header(r, cursor) || !create_map(cursor->width, cursor->height)) {
+        printf("Invalid map data\n");
+        return false;
+    }
+    if (version >= 2) return true;
+
+    for (; cursor->done < cursor->stored; cursor->done++) {
+        uint32_t index = read_u32(r);
+        if (!r->ok || index >= (uint32_t)(g_map.chunks_x * g_map.chunks_y)) return false;
+        if (!read_chunk_tiles(r, &g_map.chunks[index])) return false;
+    }
+    return true;
+}
+
+bool check_map_batch(SaveReader* r, MapCursor* cursor) {
+    int width = read_i32(r);
+    int height = read_i32(r);
+    uint32_t count = read_u32(r);
+    if (!r->ok || width != cursor->width || height != cursor->height ||
+        count > cursor->stored - cursor->done) {
+        return false;
+    }
+
+    uint32_t num_chunks = count_map_chunks(width, height);
+    if (!check_chunk_list(r, num_chunks, count, cursor->seen)) return false;
+    cursor->done += count;
+    return true;
+}
+
+// Read a batch straight into the map load_map_data created
+bool load_map_batch(SaveReader* r, MapCursor* cursor) {
+    int width = read_i32(r);
+    int height = read_i32(r);
+    uint32_t count = read_u32(r);
+    if (!r->ok || width != g_map.width || height != g_map.height ||
+        count > cursor->stored - cursor->done) {
+        return false;
+    }
+
+    uint32_t num_chunks = (uint32_t)(g_map.chunks_x * g_map.chunks_y);
+    for (uint32_t n = 0; n < count; n++) {
+        uint32_t index = read_u32(r);
+        if (!r->ok || index >= num_chunks) return false;
+        if (!read_chunk_tiles(r, &g_map.chunks[index])) return false;
+    }
+    cursor->done += count;
+    return true;
+}
+
+uint32_t get_map_generation(void) {
+    return g_map_generation;
+}
+
+// Journal support: only the chunks edited after generation since, in the
+// same layout as a batch
+void save_map_delta(SaveWriter* w, uint32_t since) {
+    int num_chunks = g_map.chunks_x * g_map.chunks_y;
+    int changed = 0;
+    for (int i = 0; i < num_chunks; i++) {
+        if (g_map.chunks[i].generation > since) changed++;
+    }
+
+    write_i32(w, g_map.width);
+    write_i32(w, g_map.height);
+    write_u32(w, (uint32_t)changed);
+
+    for (int i = 0; i < num_chunks; i++) {
+        const MapChunk* chunk = &g_map.chunks[i];
+        if (chunk->generation <= since) continue;
+
+        write_u32(w, (uint32_t)i);
+        write_bytes(w, chunk->tiles, CHUNK_SIZE * CHUNK_SIZE * sizeof(Tile));
+    }
+}
+
+bool check_map_delta(SaveReader* r, int width, int height) {
+    if (read_i32(r) != width || read_i32(r) != height) return false;
+    uint32_t changed = read_u32(r);
+    return r->ok && check_chunk_list(r, count_map_chunks(width, height), changed, NULL);
+}
+
+// Apply a delta on top of the loaded map; deltas go oldest first
+bool load_map_delta(SaveReader* r) {
+    int width = read_i32(r);
+    int height = read_i32(r);
+    uint32_t changed = read_u32(r);
+    uint32_t num_chunks = (uint32_t)(g_map.chunks_x * g_map.chunks_y);
+    if (!r->ok || width != g_map.width || height != g_map.height || changed > num_chunks) {
+        printf("Invalid map delta\n");
+        return false;
+    }
+
+    for (uint32_t n = 0; n < changed; n++) {
+        uint32_t index = read_u32(r);
+        if (!r->ok || index >= num_chunks) return false;
+        if (!read_chunk_tiles(r, &g_map.chunks[index])) return false;
+    }
+    return true;
+}
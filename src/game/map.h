@@ -0,0 +1,66 @@
+#ifndef MAP_H
+#define MAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../core/serialize.h"
+
+// Runtime-sized tile map stored in CHUNK_SIZE x CHUNK_SIZE chunks.
+// Chunk tiles are only allocated once something on them is modified.
+
+#define CHUNK_SIZE 32
+#define MAX_MAP_SIZE 1024
+#define DEFAULT_MAP_SIZE 32
+
+// Map lifetime
+bool create_map(int width, int height);
+void init_map(void);
+
+// Dimensions
+int get_map_width(void);
+int get_map_height(void);
+int get_map_chunks_x(void);
+int get_map_chunks_y(void);
+
+// Tile access (out of range reads return flat grass)
+int get_tile_height(int x, int y);
+int get_tile_type(int x, int y);
+void set_tile_height(int x, int y, int height);
+void set_tile_type(int x, int y, int type);
+
+// Chunk state
+bool is_map_chunk_allocated(int cx, int cy);
+int get_map_chunk_max_height(int cx, int cy);
+
+// Save/Load support. The map chunk holds the dimensions; the tiles go in
+// batches of up to MAP_BATCH_CHUNKS chunks written after it, so saving and
+// loading handle one batch at a time. Loads check every batch before the
+// map is replaced, then read them again straight into the new map.
+#define MAP_BATCH_CHUNKS 64
+#define MAX_MAP_CHUNKS ((MAX_MAP_SIZE / CHUNK_SIZE) * (MAX_MAP_SIZE / CHUNK_SIZE))
+
+// Progress through a map's batches as they are read
+typedef struct {
+    int width, height;
+    uint32_t stored;        // Chunks the batches must add up to
+    uint32_t done;          // Chunks read so far
+    uint8_t seen[MAX_MAP_CHUNKS];   // Chunks already checked, so none repeats
+} MapCursor;
+
+void save_map_data(SaveWriter* w);
+int count_map_batches(void);
+int save_map_batch(SaveWriter* w, int cursor);  // Returns the next batch's cursor
+bool check_map_data(SaveReader* r, uint16_t version, MapCursor* cursor);
+bool load_map_data(SaveReader* r, uint16_t version, MapCursor* cursor);
+bool check_map_batch(SaveReader* r, MapCursor* cursor);
+bool load_map_batch(SaveReader* r, MapCursor* cursor);
+
+// Autosave journal support. Every tile edit bumps the map generation;
+// a delta holds the chunks edited after a given generation.
+uint32_t get_map_generation(void);
+void save_map_delta(SaveWriter* w, uint32_t since);
+bool check_map_delta(SaveReader* r, int width, int height);
+bool load_map_delta(SaveReader* r);
+
+#endif // MAP_H
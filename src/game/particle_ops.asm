@@ -0,0 +1,180 @@
+; Weather particle update kernels over SoA float arrays
+; Optimized for x86-64 (SSE2)
+
+section .rodata
+    align 16
+inv_two_pi:     dd 0x3E22F983, 0x3E22F983, 0x3E22F983, 0x3E22F983   ; 1 / (2 pi)
+two_pi:         dd 0x40C90FDB, 0x40C90FDB, 0x40C90FDB, 0x40C90FDB   ; 2 pi
+pi:             dd 0x40490FDB, 0x40490FDB, 0x40490FDB, 0x40490FDB   ; pi
+half_pi:        dd 0x3FC90FDB, 0x3FC90FDB, 0x3FC90FDB, 0x3FC90FDB   ; pi / 2
+sign_mask:      dd 0x80000000, 0x80000000, 0x80000000, 0x80000000
+abs_mask:       dd 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF
+sin_c3:         dd 0xBE2AAAAB, 0xBE2AAAAB, 0xBE2AAAAB, 0xBE2AAAAB   ; -1 / 3!
+sin_c5:         dd 0x3C088889, 0x3C088889, 0x3C088889, 0x3C088889   ;  1 / 5!
+sin_c7:         dd 0xB9500D01, 0xB9500D01, 0xB9500D01, 0xB9500D01   ; -1 / 7!
+sin_c9:         dd 0x3638EF1D, 0x3638EF1D, 0x3638EF1D, 0x3638EF1D   ;  1 / 9!
+
+section .text
+    global advance_particles_asm
+    global advance_snow_asm
+
+; Fall and drift a run of particles in a straight line
+; void advance_particles_asm(float* x, float* y, const float* velocity, int count,
+;                            float dt, float drift)
+; Arguments: rdi=x, rsi=y, rdx=velocity, ecx=count, xmm0=dt, xmm1=drift
+; y += velocity * dt, x += drift * dt
+advance_particles_asm:
+    test ecx, ecx
+    jle .done
+
+    mulss xmm1, xmm0        ; drift * dt
+    shufps xmm0, xmm0, 0
+    shufps xmm1, xmm1, 0
+
+    ; 4 particles per iteration
+    mov r8d, ecx
+    shr r8d, 2
+    jz .tail
+
+.loop4:
+    movups xmm2, [rdx]
+    mulps xmm2, xmm0
+    movups xmm3, [rsi]
+    addps xmm3, xmm2
+    movups [rsi], xmm3
+    movups xmm3, [rdi]
+    addps xmm3, xmm1
+    movups [rdi], xmm3
+    add rdi, 16
+    add rsi, 16
+    add rdx, 16
+    dec r8d
+    jnz .loop4
+
+.tail:
+    and ecx, 3
+    jz .done
+
+.loop1:
+    movss xmm2, [rdx]
+    mulss xmm2, xmm0
+    movss xmm3, [rsi]
+    addss xmm3, xmm2
+    movss [rsi], xmm3
+    movss xmm3, [rdi]
+    addss xmm3, xmm1
+    movss [rdi], xmm3
+    add rdi, 4
+    add rsi, 4
+    add rdx, 4
+    dec ecx
+    jnz .loop1
+
+.done:
+    ret
+
+
+; Four-lane sine, accurate to ~1e-4 for the angles the particles use
+; Input/output: xmm3 (radians). Clobbers xmm4-xmm6.
+sin_ps:
+    ; Reduce to [-pi, pi] by removing the nearest whole turn
+    movaps xmm4, xmm3
+    mulps xmm4, [rel inv_two_pi]
+    cvtps2dq xmm4, xmm4
+    cvtdq2ps xmm4, xmm4
+    mulps xmm4, [rel two_pi]
+    subps xmm3, xmm4
+
+    ; Fold into [-pi/2, pi/2] using sin(r) = sin(+-pi - r)
+    movaps xmm4, xmm3
+    andps xmm4, [rel sign_mask]
+    orps xmm4, [rel pi]     ; pi with the sign of r
+    subps xmm4, xmm3
+    movaps xmm5, xmm3
+    andps xmm5, [rel abs_mask]
+    cmpnleps xmm5, [rel half_pi]
+    andps xmm4, xmm5
+    andnps xmm5, xmm3
+    orps xmm4, xmm5
+    movaps xmm3, xmm4
+
+    ; Odd Taylor polynomial: r + r^3 * (c3 + r^2 * (c5 + r^2 * (c7 + r^2 * c9)))
+    movaps xmm5, xmm3
+    mulps xmm5, xmm5        ; r^2
+    movaps xmm6, [rel sin_c9]
+    mulps xmm6, xmm5
+    addps xmm6, [rel sin_c7]
+    mulps xmm6, xmm5
+    addps xmm6, [rel sin_c5]
+    mulps xmm6, xmm5
+    addps xmm6, [rel sin_c3]
+    mulps xmm6, xmm5
+    mulps xmm6, xmm3
+    addps xmm3, xmm6
+    ret
+
+
+; Fall and sway a run of snowflakes
+; void advance_snow_asm(float* x, float* y, const float* velocity, int count,
+;                       float dt, float sway, float frequency)
+; Arguments: rdi=x, rsi=y, rdx=velocity, ecx=count, xmm0=dt, xmm1=sway, xmm2=frequency
+; y += velocity * dt, x += sin(y * frequency) * sway * dt (using the new y)
+advance_snow_asm:
+    test ecx, ecx
+    jle .done
+
+    mulss xmm1, xmm0        ; sway * dt
+    shufps xmm0, xmm0, 0
+    shufps xmm1, xmm1, 0
+    shufps xmm2, xmm2, 0
+
+    ; 4 particles per iteration
+    mov r8d, ecx
+    shr r8d, 2
+    jz .tail
+
+.loop4:
+    movups xmm3, [rdx]
+    mulps xmm3, xmm0
+    movups xmm7, [rsi]
+    addps xmm7, xmm3
+    movups [rsi], xmm7
+    movaps xmm3, xmm7
+    mulps xmm3, xmm2
+    call sin_ps
+    mulps xmm3, xmm1
+    movups xmm7, [rdi]
+    addps xmm7, xmm3
+    movups [rdi], xmm7
+    add rdi, 16
+    add rsi, 16
+    add rdx, 16
+    dec r8d
+    jnz .loop4
+
+.tail:
+    and ecx, 3
+    jz .done
+
+.loop1:
+    ; Same maths in lane 0; movss zeroes the upper lanes
+    movss xmm3, [rdx]
+    mulss xmm3, xmm0
+    movss xmm7, [rsi]
+    addss xmm7, xmm3
+    movss [rsi], xmm7
+    movaps xmm3, xmm7
+    mulps xmm3, xmm2
+    call sin_ps
+    mulss xmm3, xmm1
+    movss xmm7, [rdi]
+    addss xmm7, xmm3
+    movss [rdi], xmm7
+    add rdi, 4
+    add rsi, 4
+    add rdx, 4
+    dec ecx
+    jnz .loop1
+
+.done:
+    ret
@@ -5,8 +5,10 @@
 #include <string.h>
 #include <math.h>
 
-#define MAP_SIZE 32
+#include "map.h"
+
 #define MAX_PATH_LENGTH 256
+#define MAX_SEARCH_NODES 4096  // Bounds the search on large maps
 
 typedef struct {
     int x, y;
@@ -21,13 +23,17 @@ typedef struct {
 } Node;
 
 typedef struct {
-    Node nodes[MAP_SIZE * MAP_SIZE];
+    Node nodes[MAX_SEARCH_NODES];
     int count;
 } NodeList;
 
+// Too large for the stack once MAX_SEARCH_NODES grows
+static NodeList g_open_list;
+static NodeList g_closed_list;
+
 // Simple tile passability check (would be expanded)
 static bool is_walkable(int x, int y) {
-    if (x < 0 || x >= MAP_SIZE || y < 0 || y >= MAP_SIZE) {
+    if (x < 0 || x >= get_map_width() || y < 0 || y >= get_map_height()) {
         return false;
     }
     // For now, everything is walkable
@@ -85,8 +91,10 @@ static void remove_node(NodeList* list, int index) {
 
 // A* pathfinding implementation
 int find_path(int start_x, int start_y, int end_x, int end_y, Point* path, int max_length) {
-    NodeList open_list = {0};
-    NodeList closed_list = {0};
+    NodeList* open_list = &g_open_list;
+    NodeList* closed_list = &g_closed_list;
+    open_list->count = 0;
+    closed_list->count = 0;
     
     // Add start node to open list
     Node start_node = {0};
@@ -98,21 +106,24 @@ int find_path(int start_x, int start_y, int end_x, int end_y, Point* path, int m
     start_node.parent.x = -1;
     start_node.parent.y = -1;
     
-    open_list.nodes[0] = start_node;
-    open_list.count = 1;
+    open_list->nodes[0] = start_node;
+    open_list->count = 1;
     
     // Neighbor offsets (4-directional for now)
     int dx[] = {0, 1, 0, -1};
     int dy[] = {-1, 0, 1, 0};
     
-    while (open_list.count > 0) {
+    while (open_list->count > 0) {
         // Get node with lowest f_cost
-        int current_idx = find_lowest_f_cost(&open_list);
-        Node current = open_list.nodes[current_idx];
+        int current_idx = find_lowest_f_cost(open_list);
+        Node current = open_list->nodes[current_idx];
         
         // Move to closed list
-        remove_node(&open_list, current_idx);
-        closed_list.nodes[closed_list.count++] = current;
+        remove_node(open_list, current_idx);
+        if (closed_list->count >= MAX_SEARCH_NODES) {
+            return 0; // Search budget exhausted
+        }
+        closed_list->nodes[closed_list->count++] = current;
         
         // Check if we reached the end
         if (current.pos.x == end_x && current.pos.y == end_y) {
@@ -122,7 +133,7 @@ int find_path(int start_x, int start_y, int end_x, int end_y, Point* path, int m
             
             while (pos.x != -1 && pos.y != -1 && path_length < max_length) {
                 path[path_length++] = pos;
-                Node* parent_node = get_node(&closed_list, pos.x, pos.y);
+                Node* parent_node = get_node(closed_list, pos.x, pos.y);
                 if (parent_node) {
                     pos = parent_node->parent;
                 } else {
@@ -145,16 +156,16 @@ int find_path(int start_x, int start_y, int end_x, int end_y, Point* path, int m
             int nx = current.pos.x + dx[i];
             int ny = current.pos.y + dy[i];
             
-            if (!is_walkable(nx, ny) || is_in_list(&closed_list, nx, ny)) {
+            if (!is_walkable(nx, ny) || is_in_list(closed_list, nx, ny)) {
                 continue;
             }
             
             int new_g_cost = current.g_cost + 1;
-            Node* neighbor = get_node(&open_list, nx, ny);
+            Node* neighbor = get_node(open_list, nx, ny);
             
             if (neighbor == NULL) {
                 // Add new node to open list
-                if (open_list.count >= MAP_SIZE * MAP_SIZE) {
+                if (open_list->count >= MAX_SEARCH_NODES) {
                     return 0; // List full
                 }
                 
@@ -166,7 +177,7 @@ int find_path(int start_x, int start_y, int end_x, int end_y, Point* path, int m
                 new_node.f_cost = new_node.g_cost + new_node.h_cost;
                 new_node.parent = current.pos;
                 
-                open_list.nodes[open_list.count++] = new_node;
+                open_list->nodes[open_list->count++] = new_node;
             } else if (new_g_cost < neighbor->g_cost) {
                 // Update existing node
                 neighbor->g_cost = new_g_cost;
@@ -3,6 +3,11 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stddef.h>
+
+#include "../core/snapshot.h"
+#include "../core/serialize.h"
+#include "../core/random.h"
 
 #define MAX_RIDES 50
 
@@ -39,6 +44,7 @@ typedef struct {
 
 static Ride g_rides[MAX_RIDES] = {0};
 static int g_num_rides = 0;
+static uint32_t g_rides_generation = 0;  // Bumped whenever a ride opens, closes or breaks
 
 void init_rides(void) {
     printf("Initializing rides system...\n");
@@ -78,6 +84,7 @@ void init_rides(void) {
     g_rides[1].queue_length = 0;
     g_rides[1].breakdown_progress = 0.0f;
     g_num_rides = 2;
+    g_rides_generation++;
 }
 
 void update_rides(float dt) {
@@ -88,8 +95,9 @@ void update_rides(float dt) {
         if (g_rides[i].status == RIDE_STATUS_OPEN) {
             g_rides[i].breakdown_progress += dt * 0.01f;
 
-            if (g_rides[i].breakdown_progress > 100.0f && (rand() % 100) < 2) {
+            if (g_rides[i].breakdown_progress > 100.0f && (game_rand() % 100) < 2) {
                 g_rides[i].status = RIDE_STATUS_BROKEN;
+                g_rides_generation++;
                 printf("Ride '%s' has broken down!\n", g_rides[i].name);
                 g_rides[i].breakdown_progress = 0.0f;
             }
@@ -97,7 +105,7 @@ void update_rides(float dt) {
 
         // Process queue
         if (g_rides[i].status == RIDE_STATUS_OPEN && g_rides[i].queue_length > 0) {
-            if ((rand() % 100) < 30) {
+            if ((game_rand() % 100) < 30) {
                 g_rides[i].queue_length--;
                 g_rides[i].total_riders++;
             }
@@ -170,23 +178,66 @@ int get_ride_queue(int idx) {
     return 0;
 }
 
+uint32_t get_rides_generation(void) {
+    return g_rides_generation;
+}
+
+// Copy ride layout and status for the renderer and UI
+void write_rides_snapshot(SimSnapshot* snap) {
+    int count = g_num_rides < SNAPSHOT_MAX_RIDES ? g_num_rides : SNAPSHOT_MAX_RIDES;
+
+    for (int i = 0; i < count; i++) {
+        SnapshotRide* ride = &snap->rides[i];
+        ride->active = g_rides[i].active;
+        ride->x = g_rides[i].x;
+        ride->y = g_rides[i].y;
+        ride->width = g_rides[i].width;
+        ride->height = g_rides[i].height;
+        ride->status = g_rides[i].status;
+        ride->queue_length = g_rides[i].queue_length;
+        memcpy(ride->name, g_rides[i].name, sizeof(ride->name));
+    }
+
+    snap->num_rides = count;
+    snap->rides_generation = g_rides_generation;
+}
+
 // Repair ride
 void repair_ride(int idx) {
     if (idx >= 0 && idx < g_num_rides && g_rides[idx].active) {
         if (g_rides[idx].status == RIDE_STATUS_BROKEN) {
             g_rides[idx].status = RIDE_STATUS_OPEN;
+            g_rides_generation++;
             printf("Ride '%s' has been repaired!\n", g_rides[idx].name);
         }
     }
 }
 
-// Save/Load support
-void save_ride_data(FILE* f) {
-    fwrite(&g_num_rides, sizeof(int), 1, f);
-    fwrite(g_rides, sizeof(Ride), MAX_RIDES, f);
-}
-
-void load_ride_data(FILE* f) {
-    fread(&g_num_rides, sizeof(int), 1, f);
-    fread(g_rides, sizeof(Ride), MAX_RIDES, f);
+// Save/Load support. The slot index precedes each record; fields are only
+// ever appended to this table.
+static const FieldDesc g_ride_fields[] = {
+    FIELD(FIELD_U8,     Ride, type),
+    FIELD(FIELD_STRING, Ride, name),
+    FIELD(FIELD_I32,    Ride, x),
+    FIELD(FIELD_I32,    Ride, y),
+    FIELD(FIELD_I32,    Ride, width),
+    FIELD(FIELD_I32,    Ride, height),
+    FIELD(FIELD_U8,     Ride, status),
+    FIELD(FIELD_I32,    Ride, excitement),
+    FIELD(FIELD_I32,    Ride, intensity),
+    FIELD(FIELD_I32,    Ride, nausea),
+    FIELD(FIELD_I32,    Ride, price),
+    FIELD(FIELD_I32,    Ride, total_riders),
+    FIELD(FIELD_I32,    Ride, queue_length),
+    FIELD(FIELD_F32,    Ride, breakdown_progress),
+};
+
+// Guests refer to rides by index, so each ride keeps its slot
+static const RecordStore g_ride_store = {
+    g_rides, sizeof(Ride), MAX_RIDES, &g_num_rides, (int)offsetof(Ride, active), true,
+    g_ride_fields, NUM_FIELDS(g_ride_fields), &g_rides_generation
+};
+
+const RecordStore* get_ride_store(void) {
+    return &g_ride_store;
 }
@@ -2,6 +2,12 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "../core/snapshot.h"
+#include "../core/serialize.h"
+#include "../core/random.h"
 
 #define MAX_SCENERY 500
 
@@ -26,6 +32,7 @@ typedef struct {
 
 static Scenery g_scenery[MAX_SCENERY] = {0};
 static int g_num_scenery = 0;
+static uint32_t g_scenery_generation = 0;  // Bumped whenever scenery is added or removed
 
 void init_scenery(void) {
     printf("Initializing scenery system...\n");
@@ -34,8 +41,8 @@ void init_scenery(void) {
     for (int i = 0; i < 15; i++) {
         g_scenery[i].active = true;
         g_scenery[i].type = (i % 2 == 0) ? SCENERY_TREE_OAK : SCENERY_TREE_PINE;
-        g_scenery[i].x = 2 + (rand() % 28);
-        g_scenery[i].y = 2 + (rand() % 28);
+        g_scenery[i].x = 2 + (game_rand() % 28);
+        g_scenery[i].y = 2 + (game_rand() % 28);
         g_scenery[i].color = (g_scenery[i].type == SCENERY_TREE_OAK) ? 0x228B22 : 0x0F4D0F;
         g_scenery[i].cost = 50;
     }
@@ -71,6 +78,7 @@ void init_scenery(void) {
     }
 
     g_num_scenery = 30;
+    g_scenery_generation++;
 }
 
 bool add_scenery(SceneryType type, int x, int y) {
@@ -117,6 +125,7 @@ bool add_scenery(SceneryType type, int x, int y) {
     }
 
     g_num_scenery++;
+    g_scenery_generation++;
     return true;
 }
 
@@ -124,6 +133,7 @@ void remove_scenery_at(int x, int y) {
     for (int i = 0; i < g_num_scenery; i++) {
         if (g_scenery[i].active && g_scenery[i].x == x && g_scenery[i].y == y) {
             g_scenery[i].active = false;
+            g_scenery_generation++;
             printf("Removed scenery at (%d, %d)\n", x, y);
             return;
         }
@@ -148,6 +158,25 @@ void get_scenery_info(int idx, int* x, int* y, SceneryType* type, uint32_t* colo
     }
 }
 
+uint32_t get_scenery_generation(void) {
+    return g_scenery_generation;
+}
+
+// Copy active scenery for the renderer and light map
+void write_scenery_snapshot(SimSnapshot* snap) {
+    int count = 0;
+    for (int i = 0; i < g_num_scenery && count < SNAPSHOT_MAX_SCENERY; i++) {
+        if (!g_scenery[i].active) continue;
+        snap->scenery[count].x = g_scenery[i].x;
+        snap->scenery[count].y = g_scenery[i].y;
+        snap->scenery[count].type = g_scenery[i].type;
+        snap->scenery[count].color = g_scenery[i].color;
+        count++;
+    }
+    snap->num_scenery = count;
+    snap->scenery_generation = g_scenery_generation;
+}
+
 SceneryType get_scenery_at(int x, int y) {
     for (int i = 0; i < g_num_scenery; i++) {
         if (g_scenery[i].active && g_scenery[i].x == x && g_scenery[i].y == y) {
@@ -172,13 +201,21 @@ bool is_trash_can_nearby(int x, int y, int radius) {
     return false;
 }
 
-// Save/Load support
-void save_scenery_data(FILE* f) {
-    fwrite(&g_num_scenery, sizeof(int), 1, f);
-    fwrite(g_scenery, sizeof(Scenery), MAX_SCENERY, f);
-}
-
-void load_scenery_data(FILE* f) {
-    fread(&g_num_scenery, sizeof(int), 1, f);
-    fread(g_scenery, sizeof(Scenery), MAX_SCENERY, f);
+// Save/Load support. The slot index precedes each record; fields are only
+// ever appended to this table.
+static const FieldDesc g_scenery_fields[] = {
+    FIELD(FIELD_U8,  Scenery, type),
+    FIELD(FIELD_I32, Scenery, x),
+    FIELD(FIELD_I32, Scenery, y),
+    FIELD(FIELD_U32, Scenery, color),
+    FIELD(FIELD_I32, Scenery, cost),
+};
+
+static const RecordStore g_scenery_store = {
+    g_scenery, sizeof(Scenery), MAX_SCENERY, &g_num_scenery, (int)offsetof(Scenery, active), true,
+    g_scenery_fields, NUM_FIELDS(g_scenery_fields), &g_scenery_generation
+};
+
+const RecordStore* get_scenery_store(void) {
+    return &g_scenery_store;
 }
@@ -3,6 +3,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stddef.h>
+
+#include "../core/snapshot.h"
+#include "../core/serialize.h"
 
 #define MAX_SHOPS 50
 
@@ -155,6 +159,19 @@ int get_shop_at(int x, int y) {
     return -1;
 }
 
+// Copy active shops for the renderer
+void write_shops_snapshot(SimSnapshot* snap) {
+    int count = 0;
+    for (int i = 0; i < g_num_shops && count < SNAPSHOT_MAX_SHOPS; i++) {
+        if (!g_shops[i].active) continue;
+        snap->shops[count].x = g_shops[i].x;
+        snap->shops[count].y = g_shops[i].y;
+        snap->shops[count].type = g_shops[i].type;
+        count++;
+    }
+    snap->num_shops = count;
+}
+
 int get_total_shop_revenue(void) {
     int total = 0;
     for (int i = 0; i < g_num_shops; i++) {
@@ -165,13 +182,24 @@ int get_total_shop_revenue(void) {
     return total;
 }
 
-// Save/Load support
-void save_shop_data(FILE* f) {
-    fwrite(&g_num_shops, sizeof(int), 1, f);
-    fwrite(g_shops, sizeof(Shop), MAX_SHOPS, f);
-}
-
-void load_shop_data(FILE* f) {
-    fread(&g_num_shops, sizeof(int), 1, f);
-    fread(g_shops, sizeof(Shop), MAX_SHOPS, f);
+// Save/Load support. The slot index precedes each record; fields are only
+// ever appended to this table.
+static const FieldDesc g_shop_fields[] = {
+    FIELD(FIELD_U8,     Shop, type),
+    FIELD(FIELD_STRING, Shop, name),
+    FIELD(FIELD_I32,    Shop, x),
+    FIELD(FIELD_I32,    Shop, y),
+    FIELD(FIELD_I32,    Shop, price),
+    FIELD(FIELD_I32,    Shop, total_sales),
+    FIELD(FIELD_I32,    Shop, total_revenue),
+};
+
+// Guests refer to shops by index, so each shop keeps its slot
+static const RecordStore g_shop_store = {
+    g_shops, sizeof(Shop), MAX_SHOPS, &g_num_shops, (int)offsetof(Shop, active), true,
+    g_shop_fields, NUM_FIELDS(g_shop_fields), NULL
+};
+
+const RecordStore* get_shop_store(void) {
+    return &g_shop_store;
 }
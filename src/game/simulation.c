@@ -1,11 +1,22 @@
+#include <SDL2/SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <math.h>
 #include <string.h>
+#include <stddef.h>
+
+#include "map.h"
+#include "../core/snapshot.h"
+#include "../core/profiler.h"
+#include "../core/serialize.h"
+#include "../core/random.h"
 
 #define MAX_GUESTS 100
+#define SIM_TICK_MS 16          // Simulation thread tick (~60 Hz)
+#define SIM_TICK_DT (1.0f / 60.0f)  // Every tick advances the park by the same step
+#define SIM_MAX_CATCH_UP 5      // Ticks run per wake at most; beyond that the park slows down
 
 typedef enum {
     GUEST_STATE_WANDERING,
@@ -43,10 +54,18 @@ typedef struct {
     int entrance_fee;
     int total_guests_entered;
     float time_of_day;  // 0-24 hours
+    float wage_timer;   // Seconds since wages were last paid
+    int last_spawn;     // Whole park second of the last guest arrival
 } ParkState;
 
 static Guest g_guests[MAX_GUESTS];
 static ParkState g_park = {0};
+static SDL_atomic_t g_sim_tick;      // Atomic so input can stamp commands without the lock
+
+// Simulation thread state
+static SDL_mutex* g_sim_lock = NULL;
+static SDL_Thread* g_sim_thread = NULL;
+static SDL_atomic_t g_sim_running;
 
 // External functions
 extern void init_rides(void);
@@ -78,8 +97,21 @@ extern int get_weather_happiness_modifier(void);
 extern bool is_raining(void);
 extern bool can_ride_operate_in_weather(void);
 
+// Snapshot writers owned by each subsystem
+extern void write_rides_snapshot(SimSnapshot* snap);
+extern void write_staff_snapshot(SimSnapshot* snap);
+extern void write_shops_snapshot(SimSnapshot* snap);
+extern void write_scenery_snapshot(SimSnapshot* snap);
+extern void write_litter_snapshot(SimSnapshot* snap);
+extern void write_weather_snapshot(SimSnapshot* snap);
+
+void publish_simulation_snapshot(void);
+
 void init_simulation(void) {
     printf("Initializing simulation...\n");
+
+    init_snapshots();
+    SDL_AtomicSet(&g_sim_tick, 0);
     
     g_park.num_guests = 5;
     g_park.park_rating = 800;
@@ -88,20 +120,24 @@ void init_simulation(void) {
     g_park.entrance_fee = 10;
     g_park.total_guests_entered = 5;
     g_park.time_of_day = 10.0f;  // Start at 10 AM
+    g_park.wage_timer = 0.0f;
+    g_park.last_spawn = 0;
+
+    init_map();
 
     // Initialize guests
     for (int i = 0; i < g_park.num_guests; i++) {
-        g_guests[i].x = 5.0f + (rand() % 3);
-        g_guests[i].y = 5.0f + (rand() % 3);
+        g_guests[i].x = 5.0f + (game_rand() % 3);
+        g_guests[i].y = 5.0f + (game_rand() % 3);
         g_guests[i].target_x = 16.0f;
         g_guests[i].target_y = 16.0f;
-        g_guests[i].speed = 2.0f + (rand() % 100) / 100.0f;
-        g_guests[i].happiness = 80 + (rand() % 20);
-        g_guests[i].hunger = rand() % 30;
-        g_guests[i].thirst = rand() % 30;
-        g_guests[i].energy = 80 + (rand() % 20);
-        g_guests[i].bathroom = rand() % 30;
-        g_guests[i].money = 50 + (rand() % 100);
+        g_guests[i].speed = 2.0f + (game_rand() % 100) / 100.0f;
+        g_guests[i].happiness = 80 + (game_rand() % 20);
+        g_guests[i].hunger = game_rand() % 30;
+        g_guests[i].thirst = game_rand() % 30;
+        g_guests[i].energy = 80 + (game_rand() % 20);
+        g_guests[i].bathroom = game_rand() % 30;
+        g_guests[i].money = 50 + (game_rand() % 100);
         g_guests[i].has_target = false;
         g_guests[i].state = GUEST_STATE_WANDERING;
         g_guests[i].target_ride = -1;
@@ -120,6 +156,8 @@ void init_simulation(void) {
     init_shops();
     init_litter();
     init_weather();
+
+    publish_simulation_snapshot();
 }
 
 void update_guest_ai(Guest* guest, float dt) {
@@ -136,7 +174,7 @@ void update_guest_ai(Guest* guest, float dt) {
     
     // Litter generation
     guest->litter_timer += dt;
-    if (guest->litter_timer > 30.0f && (rand() % 100) < 10) {
+    if (guest->litter_timer > 30.0f && (game_rand() % 100) < 10) {
         // Drop litter if no trash can nearby
         if (!is_trash_can_nearby((int)guest->x, (int)guest->y, 3)) {
             add_litter(guest->x, guest->y);
@@ -170,8 +208,8 @@ void update_guest_ai(Guest* guest, float dt) {
     
     // Seek shelter in rain
     if (is_raining() && guest->state == GUEST_STATE_WANDERING) {
-        if ((rand() % 100) < 30) {  // 30% chance to seek shop
-            int shop_idx = find_nearest_shop(rand() % 3, (int)guest->x, (int)guest->y);
+        if ((game_rand() % 100) < 30) {  // 30% chance to seek shop
+            int shop_idx = find_nearest_shop(game_rand() % 3, (int)guest->x, (int)guest->y);
             if (shop_idx >= 0) {
                 guest->state = GUEST_STATE_HEADING_TO_SHOP;
                 guest->target_shop = shop_idx;
@@ -210,16 +248,16 @@ void update_guest_ai(Guest* guest, float dt) {
     switch (guest->state) {
         case GUEST_STATE_WANDERING:
             if (!guest->has_target) {
-                if ((rand() % 100) < 15 && guest->money > 5 && guest->energy > 40) {
-                    int ride_idx = rand() % 2;
+                if ((game_rand() % 100) < 15 && guest->money > 5 && guest->energy > 40) {
+                    int ride_idx = game_rand() % 2;
                     if (can_guest_ride(ride_idx, guest->money)) {
                         guest->state = GUEST_STATE_HEADING_TO_RIDE;
                         guest->target_ride = ride_idx;
                         strcpy(guest->thought, "Let's ride something!");
                     }
                 } else {
-                    guest->target_x = 5.0f + (rand() % 22);
-                    guest->target_y = 5.0f + (rand() % 22);
+                    guest->target_x = 5.0f + (game_rand() % 22);
+                    guest->target_y = 5.0f + (game_rand() % 22);
                     guest->has_target = true;
                     strcpy(guest->thought, "What a nice park!");
                 }
@@ -307,27 +345,44 @@ void update_guest(Guest* guest, float dt) {
     }
 
     // Keep in bounds
+    float max_x = (float)(get_map_width() - 1);
+    float max_y = (float)(get_map_height() - 1);
     if (guest->x < 0) guest->x = 0;
     if (guest->y < 0) guest->y = 0;
-    if (guest->x > 31) guest->x = 31;
-    if (guest->y > 31) guest->y = 31;
+    if (guest->x > max_x) guest->x = max_x;
+    if (guest->y > max_y) guest->y = max_y;
 }
 
 void update_simulation(float dt) {
+    PROFILE_BEGIN(PROF_SIM_TOTAL);
+
     g_park.time += dt;
     g_park.time_of_day += dt / 60.0f;  // 1 minute real time = 1 hour game time
     if (g_park.time_of_day >= 24.0f) g_park.time_of_day -= 24.0f;
 
     // Update all guests
+    PROFILE_BEGIN(PROF_SIM_GUESTS);
     for (int i = 0; i < g_park.num_guests; i++) {
         update_guest(&g_guests[i], dt);
     }
+    PROFILE_END(PROF_SIM_GUESTS);
     
     // Update subsystems
+    PROFILE_BEGIN(PROF_SIM_RIDES);
     update_rides(dt);
+    PROFILE_END(PROF_SIM_RIDES);
+
+    PROFILE_BEGIN(PROF_SIM_STAFF);
     update_staff(dt);
+    PROFILE_END(PROF_SIM_STAFF);
+
+    PROFILE_BEGIN(PROF_SIM_LITTER);
     update_litter(dt);
+    PROFILE_END(PROF_SIM_LITTER);
+
+    PROFILE_BEGIN(PROF_SIM_WEATHER);
     update_weather(dt);
+    PROFILE_END(PROF_SIM_WEATHER);
 
     // Update park rating based on happiness and litter
     int total_happiness = 0;
@@ -345,8 +400,7 @@ void update_simulation(float dt) {
 
     // Spawn new guests
     if ((int)g_park.time % 15 == 0 && g_park.num_guests < MAX_GUESTS) {
-        static int last_spawn = 0;
-        if ((int)g_park.time != last_spawn) {
+        if ((int)g_park.time != g_park.last_spawn) {
             int idx = g_park.num_guests;
             g_guests[idx].x = 5.0f;
             g_guests[idx].y = 5.0f;
@@ -368,22 +422,145 @@ void update_simulation(float dt) {
             g_park.num_guests++;
             g_park.total_guests_entered++;
             g_park.total_money += g_park.entrance_fee;
-            last_spawn = (int)g_park.time;
+            g_park.last_spawn = (int)g_park.time;
         }
     }
     
     // Monthly expenses
-    static float wage_timer = 0.0f;
-    wage_timer += dt;
-    if (wage_timer >= 30.0f) {
+    g_park.wage_timer += dt;
+    if (g_park.wage_timer >= 30.0f) {
         extern int get_total_wages(void);
         int wages = get_total_wages();
         g_park.total_money -= wages;
-        wage_timer = 0.0f;
+        g_park.wage_timer = 0.0f;
+    }
+
+    SDL_AtomicAdd(&g_sim_tick, 1);
+
+    PROFILE_BEGIN(PROF_SIM_SNAPSHOT);
+    publish_simulation_snapshot();
+    PROFILE_END(PROF_SIM_SNAPSHOT);
+
+    PROFILE_END(PROF_SIM_TOTAL);
+}
+
+// Copy the state the renderer and UI need into the snapshot back buffer and
+// publish it. Must run on the thread that updates the simulation (or under
+// the simulation lock).
+void publish_simulation_snapshot(void) {
+    SimSnapshot* snap = begin_snapshot();
+
+    snap->tick = (uint32_t)SDL_AtomicGet(&g_sim_tick);
+    snap->park_rating = g_park.park_rating;
+    snap->park_money = g_park.total_money;
+    snap->total_guests_entered = g_park.total_guests_entered;
+    snap->time_of_day = g_park.time_of_day;
+
+    int count = g_park.num_guests < SNAPSHOT_MAX_GUESTS ? g_park.num_guests : SNAPSHOT_MAX_GUESTS;
+    for (int i = 0; i < count; i++) {
+        snap->guests[i].x = g_guests[i].x;
+        snap->guests[i].y = g_guests[i].y;
+        snap->guests[i].color = g_guests[i].color;
     }
+    snap->num_guests = count;
+
+    write_rides_snapshot(snap);
+    write_staff_snapshot(snap);
+    write_shops_snapshot(snap);
+    write_scenery_snapshot(snap);
+    write_litter_snapshot(snap);
+    write_weather_snapshot(snap);
+
+    publish_snapshot();
+}
+
+// Anything that mutates simulation state from another thread (tools, save,
+// load) must hold this lock. No-op when the simulation runs single-threaded.
+void lock_simulation(void) {
+    if (g_sim_lock) SDL_LockMutex(g_sim_lock);
+}
+
+void unlock_simulation(void) {
+    if (g_sim_lock) SDL_UnlockMutex(g_sim_lock);
+}
+
+// Advance the park by one fixed tick
+void step_simulation(void) {
+    update_simulation(SIM_TICK_DT);
+}
+
+static int simulation_thread(void* data) {
+    (void)data;
+
+    uint64_t last_time = SDL_GetPerformanceCounter();
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    double pending = 0.0;   // Real time not yet simulated, in seconds
+
+    while (SDL_AtomicGet(&g_sim_running)) {
+        uint64_t current_time = SDL_GetPerformanceCounter();
+        pending += (current_time - last_time) / frequency;
+        last_time = current_time;
+
+        // Whole fixed steps only, so tick N is the same park on every run and
+        // a command journal can name the tick it happened on
+        int ticks = 0;
+        while (pending >= SIM_TICK_DT && ticks < SIM_MAX_CATCH_UP) {
+            lock_simulation();
+            step_simulation();
+            unlock_simulation();
+            pending -= SIM_TICK_DT;
+            ticks++;
+        }
+        if (ticks == SIM_MAX_CATCH_UP) pending = 0.0;
+
+        // Sleep off the rest of the tick
+        uint32_t elapsed_ms = (uint32_t)((SDL_GetPerformanceCounter() - current_time) * 1000.0 / frequency);
+        SDL_Delay(elapsed_ms < SIM_TICK_MS ? SIM_TICK_MS - elapsed_ms : 1);
+    }
+
+    return 0;
+}
+
+// Run update_simulation() on its own thread, publishing a snapshot per tick
+bool start_simulation_thread(void) {
+    if (g_sim_thread) return true;
+
+    g_sim_lock = SDL_CreateMutex();
+    if (!g_sim_lock) {
+        printf("Simulation lock creation failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    SDL_AtomicSet(&g_sim_running, 1);
+    g_sim_thread = SDL_CreateThread(simulation_thread, "simulation", NULL);
+    if (!g_sim_thread) {
+        printf("Simulation thread creation failed: %s\n", SDL_GetError());
+        SDL_DestroyMutex(g_sim_lock);
+        g_sim_lock = NULL;
+        return false;
+    }
+
+    printf("Simulation thread started\n");
+    return true;
+}
+
+void stop_simulation_thread(void) {
+    if (!g_sim_thread) return;
+
+    SDL_AtomicSet(&g_sim_running, 0);
+    SDL_WaitThread(g_sim_thread, NULL);
+    g_sim_thread = NULL;
+
+    SDL_DestroyMutex(g_sim_lock);
+    g_sim_lock = NULL;
 }
 
 // Getters
+// Ticks run since the park was created; saved with it
+uint32_t get_simulation_tick(void) {
+    return (uint32_t)SDL_AtomicGet(&g_sim_tick);
+}
+
 int get_num_guests(void) {
     return g_park.num_guests;
 }
@@ -446,14 +623,47 @@ void set_park_state(int rating, int money, int guests, float time, float tod, in
     g_park.entrance_fee = entrance_fee;
 }
 
-void save_guest_data(FILE* f) {
-    for (int i = 0; i < g_park.num_guests; i++) {
-        fwrite(&g_guests[i], sizeof(Guest), 1, f);
-    }
+// Clock state outside the summary above. A loaded park needs it to carry on
+// exactly as it would have, which is what makes command replay repeatable.
+void get_park_clock(uint32_t* tick, float* wage_timer, int* last_spawn) {
+    *tick = (uint32_t)SDL_AtomicGet(&g_sim_tick);
+    *wage_timer = g_park.wage_timer;
+    *last_spawn = g_park.last_spawn;
 }
 
-void load_guest_data(FILE* f) {
-    for (int i = 0; i < g_park.num_guests; i++) {
-        fread(&g_guests[i], sizeof(Guest), 1, f);
-    }
-}
\ No newline at end of file
+void set_park_clock(uint32_t tick, float wage_timer, int last_spawn) {
+    SDL_AtomicSet(&g_sim_tick, (int)tick);
+    g_park.wage_timer = wage_timer;
+    g_park.last_spawn = last_spawn;
+}
+
+// Guest records; fields are only ever appended to this table
+static const FieldDesc g_guest_fields[] = {
+    FIELD(FIELD_F32,    Guest, x),
+    FIELD(FIELD_F32,    Guest, y),
+    FIELD(FIELD_F32,    Guest, target_x),
+    FIELD(FIELD_F32,    Guest, target_y),
+    FIELD(FIELD_F32,    Guest, speed),
+    FIELD(FIELD_I32,    Guest, happiness),
+    FIELD(FIELD_I32,    Guest, hunger),
+    FIELD(FIELD_I32,    Guest, thirst),
+    FIELD(FIELD_I32,    Guest, energy),
+    FIELD(FIELD_I32,    Guest, bathroom),
+    FIELD(FIELD_I32,    Guest, money),
+    FIELD(FIELD_BOOL,   Guest, has_target),
+    FIELD(FIELD_U32,    Guest, color),
+    FIELD(FIELD_U8,     Guest, state),
+    FIELD(FIELD_I32,    Guest, target_ride),
+    FIELD(FIELD_I32,    Guest, target_shop),
+    FIELD(FIELD_STRING, Guest, thought),
+    FIELD(FIELD_F32,    Guest, litter_timer),
+};
+
+static const RecordStore g_guest_store = {
+    g_guests, sizeof(Guest), MAX_GUESTS, &g_park.num_guests, -1, false,
+    g_guest_fields, NUM_FIELDS(g_guest_fields), NULL
+};
+
+const RecordStore* get_guest_store(void) {
+    return &g_guest_store;
+}
@@ -2,8 +2,15 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+#include <stddef.h>
 #include <math.h>
 
+#include "map.h"
+#include "../core/snapshot.h"
+#include "../core/serialize.h"
+#include "../core/random.h"
+
 #define MAX_STAFF 20
 
 typedef enum {
@@ -95,8 +102,8 @@ void update_staff_member(Staff* staff, float dt) {
                 staff->is_working = true;
             } else {
                 // No litter, patrol
-                staff->target_x = staff->patrol_area_x + (rand() % (staff->patrol_radius * 2)) - staff->patrol_radius;
-                staff->target_y = staff->patrol_area_y + (rand() % (staff->patrol_radius * 2)) - staff->patrol_radius;
+                staff->target_x = staff->patrol_area_x + (game_rand() % (staff->patrol_radius * 2)) - staff->patrol_radius;
+                staff->target_y = staff->patrol_area_y + (game_rand() % (staff->patrol_radius * 2)) - staff->patrol_radius;
                 staff->has_target = true;
                 staff->is_working = false;
             }
@@ -121,8 +128,8 @@ void update_staff_member(Staff* staff, float dt) {
     } else {
         // Other staff types patrol
         if (!staff->has_target || staff->energy < 30) {
-            staff->target_x = staff->patrol_area_x + (rand() % (staff->patrol_radius * 2)) - staff->patrol_radius;
-            staff->target_y = staff->patrol_area_y + (rand() % (staff->patrol_radius * 2)) - staff->patrol_radius;
+            staff->target_x = staff->patrol_area_x + (game_rand() % (staff->patrol_radius * 2)) - staff->patrol_radius;
+            staff->target_y = staff->patrol_area_y + (game_rand() % (staff->patrol_radius * 2)) - staff->patrol_radius;
             staff->has_target = true;
 
             if (staff->energy < 30) {
@@ -147,10 +154,12 @@ void update_staff_member(Staff* staff, float dt) {
     }
 
     // Keep in bounds
+    float max_x = (float)(get_map_width() - 1);
+    float max_y = (float)(get_map_height() - 1);
     if (staff->x < 0) staff->x = 0;
     if (staff->y < 0) staff->y = 0;
-    if (staff->x > 31) staff->x = 31;
-    if (staff->y > 31) staff->y = 31;
+    if (staff->x > max_x) staff->x = max_x;
+    if (staff->y > max_y) staff->y = max_y;
 }
 
 void update_staff(float dt) {
@@ -179,6 +188,19 @@ StaffType get_staff_type(int index) {
     return STAFF_JANITOR;
 }
 
+// Copy active staff positions for the renderer
+void write_staff_snapshot(SimSnapshot* snap) {
+    int count = 0;
+    for (int i = 0; i < g_num_staff && count < SNAPSHOT_MAX_STAFF; i++) {
+        if (!g_staff[i].active) continue;
+        snap->staff[count].x = g_staff[i].x;
+        snap->staff[count].y = g_staff[i].y;
+        snap->staff[count].type = g_staff[i].type;
+        count++;
+    }
+    snap->num_staff = count;
+}
+
 // Send mechanic to broken ride
 void dispatch_mechanic(int ride_x, int ride_y) {
     for (int i = 0; i < g_num_staff; i++) {
@@ -203,13 +225,28 @@ int get_total_wages(void) {
     return total;
 }
 
-// Save/Load support
-void save_staff_data(FILE* f) {
-    fwrite(&g_num_staff, sizeof(int), 1, f);
-    fwrite(g_staff, sizeof(Staff), MAX_STAFF, f);
-}
-
-void load_staff_data(FILE* f) {
-    fread(&g_num_staff, sizeof(int), 1, f);
-    fread(g_staff, sizeof(Staff), MAX_STAFF, f);
+// Save/Load support. The slot index precedes each record; fields are only
+// ever appended to this table.
+static const FieldDesc g_staff_fields[] = {
+    FIELD(FIELD_U8,   Staff, type),
+    FIELD(FIELD_F32,  Staff, x),
+    FIELD(FIELD_F32,  Staff, y),
+    FIELD(FIELD_F32,  Staff, target_x),
+    FIELD(FIELD_F32,  Staff, target_y),
+    FIELD(FIELD_BOOL, Staff, has_target),
+    FIELD(FIELD_I32,  Staff, patrol_area_x),
+    FIELD(FIELD_I32,  Staff, patrol_area_y),
+    FIELD(FIELD_I32,  Staff, patrol_radius),
+    FIELD(FIELD_F32,  Staff, energy),
+    FIELD(FIELD_I32,  Staff, wage),
+    FIELD(FIELD_BOOL, Staff, is_working),
+};
+
+static const RecordStore g_staff_store = {
+    g_staff, sizeof(Staff), MAX_STAFF, &g_num_staff, (int)offsetof(Staff, active), true,
+    g_staff_fields, NUM_FIELDS(g_staff_fields), NULL
+};
+
+const RecordStore* get_staff_store(void) {
+    return &g_staff_store;
 }
@@ -1,11 +1,33 @@
+#include <SDL2/SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include <math.h>
 
-#define MAX_RAINDROPS 500
-#define MAX_SNOWFLAKES 300
+#include "../core/snapshot.h"
+#include "../core/serialize.h"
+#include "../core/random.h"
+
+#define MAX_RAINDROPS 32768        // Heavy rain on a 1080p view peaks near 26k
+#define MAX_SNOWFLAKES 8192
+
+// Drops spawned per tick. A drop lives as long as it takes to fall through
+// the view, so heavy rain holds about 14k drops on an 800x600 view.
+#define RAIN_SPAWN 8
+#define HEAVY_RAIN_SPAWN 160
+#define SNOW_SPAWN 5
+
+#define RAIN_DRIFT 50.0f            // Pixels per second to the right
+#define SNOW_SWAY 30.0f             // Peak sideways speed in pixels per second
+#define SNOW_SWAY_FREQUENCY 0.02f   // Radians per pixel fallen
+
+// External assembly functions
+extern void advance_particles_asm(float* x, float* y, const float* velocity, int count,
+                                  float dt, float drift);
+extern void advance_snow_asm(float* x, float* y, const float* velocity, int count,
+                             float dt, float sway, float frequency);
 
 typedef enum{
     WEATHER_SUNNY,
@@ -16,12 +38,17 @@ typedef enum{
     WEATHER_FOG
 } WeatherType;
 
+// Structure-of-arrays particle storage. Live particles are packed into
+// [0, count): spawning appends, removal swaps the last particle into the gap.
+// Each column points at capacity floats owned by that pool.
 typedef struct {
-    float x, y;
-    float velocity;
-    float size;
-    float active;
-} Particle;
+    int count;
+    int capacity;
+    float* x;
+    float* y;
+    float* velocity;
+    float* size;
+} ParticlePool;
 
 typedef struct {
     WeatherType current;
@@ -35,8 +62,26 @@ typedef struct {
 } WeatherState;
 
 static WeatherState g_weather = {0};
-static Particle g_raindrops[MAX_RAINDROPS] = {0};
-static Particle g_snowflakes[MAX_SNOWFLAKES] = {0};
+
+// Column storage sized to each pool (x, y, velocity, size)
+static float g_rain_columns[4][MAX_RAINDROPS];
+static float g_snow_columns[4][MAX_SNOWFLAKES];
+
+static ParticlePool g_raindrops = {
+    .capacity = MAX_RAINDROPS,
+    .x = g_rain_columns[0], .y = g_rain_columns[1],
+    .velocity = g_rain_columns[2], .size = g_rain_columns[3]
+};
+static ParticlePool g_snowflakes = {
+    .capacity = MAX_SNOWFLAKES,
+    .x = g_snow_columns[0], .y = g_snow_columns[1],
+    .velocity = g_snow_columns[2], .size = g_snow_columns[3]
+};
+
+// Screen area particles spawn across and fall through. Set by the render
+// thread when the window changes size, read by the simulation thread.
+static SDL_atomic_t g_view_width;
+static SDL_atomic_t g_view_height;
 
 void init_weather(void) {
     printf("Initializing weather system...");
@@ -45,22 +90,17 @@ void init_weather(void) {
     g_weather.target = WEATHER_SUNNY;
     g_weather.transition_progress = 1.0f;
     g_weather.duration = 0.0f;
-    g_weather.next_change_timer = 60.0f * (rand() % 120);
+    g_weather.next_change_timer = 60.0f * (game_rand() % 120);
     g_weather.intensity = 0.5f;
     g_weather.sky_tint = 0xFFFFFF;
     g_weather.visibility = 1.0f;
 
-    for (int i = 0; i < MAX_RAINDROPS; ++i) {
-        g_raindrops[i].active = false;
-    }
-
-    for (int i = 0; i < MAX_SNOWFLAKES; ++i) {
-        g_snowflakes[i].active = false; 
-    }
+    g_raindrops.count = 0;
+    g_snowflakes.count = 0;
 }
 
 static WeatherType pick_random_weather(void) {
-    int chance = rand() % 100;
+    int chance = game_rand() % 100;
 
     if (chance < 40) return WEATHER_SUNNY;
     if (chance < 60) return WEATHER_CLOUDY;
@@ -70,68 +110,75 @@ static WeatherType pick_random_weather(void) {
     else return WEATHER_FOG;
 }
 
-static void spawn_raindrop(void) {
-    for (int i = 0; i < MAX_RAINDROPS; ++i) {
-        if (!g_raindrops[i].active) {
-            g_raindrops[i].active = true;
-            g_raindrops[i].x = (rand() % 800);
-            g_raindrops[i].y = -10.0f;
-            g_raindrops[i].velocity = 300.0f + (rand() % 200);
-            g_raindrops[i].size = 2.0f + (rand() % 2);
-            return;
-        }
-    }
+void set_weather_view_size(int width, int height) {
+    SDL_AtomicSet(&g_view_width, width);
+    SDL_AtomicSet(&g_view_height, height);
 }
 
-static void spawn_snowflake(void) {
-    for (int i = 0; i < MAX_SNOWFLAKES; ++i) {
-        if (!g_snowflakes[i].active) {
-            g_snowflakes[i].active = true;
-            g_snowflakes[i].x = (rand() % 800);
-            g_snowflakes[i].y = -10.0f;
-            g_snowflakes[i].velocity = 50.0f + (rand() % 50);
-            g_snowflakes[i].size = 2.0f + (rand() % 3);
-            return;
-        }
-    }
+static void spawn_raindrop(int view_width) {
+    ParticlePool* pool = &g_raindrops;
+    if (pool->count >= pool->capacity) return;
+
+    int i = pool->count++;
+    pool->x[i] = (effect_rand() % view_width);
+    pool->y[i] = -10.0f;
+    pool->velocity[i] = 300.0f + (effect_rand() % 200);
+    pool->size[i] = 2.0f + (effect_rand() % 2);
 }
 
-static void update_particles(float dt) {
-    if (g_weather.current == WEATHER_RAIN || g_weather.current == WEATHER_HEAVY_RAIN) {
-        int spawn_count = (g_weather.current == WEATHER_HEAVY_RAIN) ? 15 : 8;
-        for (int i = 0; i < spawn_count; ++i) {
-            spawn_raindrop();
-        }
-    }
+static void spawn_snowflake(int view_width) {
+    ParticlePool* pool = &g_snowflakes;
+    if (pool->count >= pool->capacity) return;
 
-    for (int i = 0; i < MAX_RAINDROPS; ++i) {
-        if (g_raindrops[i].active) {
-            g_raindrops[i].y += g_raindrops[i].velocity * dt;
-            g_raindrops[i].x += 50.0f * dt;
+    int i = pool->count++;
+    pool->x[i] = (effect_rand() % view_width);
+    pool->y[i] = -10.0f;
+    pool->velocity[i] = 50.0f + (effect_rand() % 50);
+    pool->size[i] = 2.0f + (effect_rand() % 3);
+}
 
-            if (g_raindrops[i].y > 600) {
-                g_raindrops[i].active = false;
-            }
+// Drop particles that have fallen past the floor, keeping the pool packed
+static void remove_fallen_particles(ParticlePool* pool, float floor_y) {
+    int i = 0;
+    while (i < pool->count) {
+        if (pool->y[i] > floor_y) {
+            int last = --pool->count;
+            pool->x[i] = pool->x[last];
+            pool->y[i] = pool->y[last];
+            pool->velocity[i] = pool->velocity[last];
+            pool->size[i] = pool->size[last];
+        } else {
+            i++;
         }
     }
+}
 
-    if (g_weather.current == WEATHER_SNOW) {
-        for (int i = 0; i < 5; ++i) {
-            spawn_snowflake();
+static void update_particles(float dt) {
+    int view_width = SDL_AtomicGet(&g_view_width);
+    float floor_y = (float)SDL_AtomicGet(&g_view_height);
+
+    // Nothing to spawn into until a renderer has reported its size
+    if (view_width > 0 && (g_weather.current == WEATHER_RAIN || g_weather.current == WEATHER_HEAVY_RAIN)) {
+        int spawn_count = (g_weather.current == WEATHER_HEAVY_RAIN) ? HEAVY_RAIN_SPAWN : RAIN_SPAWN;
+        for (int i = 0; i < spawn_count; ++i) {
+            spawn_raindrop(view_width);
         }
     }
 
-    for (int i = 0; i < MAX_SNOWFLAKES; ++i) {
-        if (g_snowflakes[i].active) {
-            g_snowflakes[i].y += g_snowflakes[i].velocity * dt;
-            // Drift left and right
-            g_snowflakes[i].x += sinf(g_snowflakes[i].y * 0.02f) * 30.0f * dt;
+    advance_particles_asm(g_raindrops.x, g_raindrops.y, g_raindrops.velocity,
+                          g_raindrops.count, dt, RAIN_DRIFT);
+    remove_fallen_particles(&g_raindrops, floor_y);
 
-            if (g_snowflakes[i].y > 600) {
-                g_snowflakes[i].active = false;
-            }
+    if (view_width > 0 && g_weather.current == WEATHER_SNOW) {
+        for (int i = 0; i < SNOW_SPAWN; ++i) {
+            spawn_snowflake(view_width);
         }
     }
+
+    // Drift left and right
+    advance_snow_asm(g_snowflakes.x, g_snowflakes.y, g_snowflakes.velocity,
+                     g_snowflakes.count, dt, SNOW_SWAY, SNOW_SWAY_FREQUENCY);
+    remove_fallen_particles(&g_snowflakes, floor_y);
 }
 
 void update_weather(float dt) {
@@ -142,7 +189,7 @@ void update_weather(float dt) {
         if (g_weather.transition_progress >= 1.0f) {
             g_weather.target = pick_random_weather();
             g_weather.transition_progress = 0.0f;
-            g_weather.next_change_timer = 60.0f + (rand() % 180);
+            g_weather.next_change_timer = 60.0f + (game_rand() % 180);
 
             const char* weather_names[] = {"Sunny", "Cloudy", "Rain", "Heavy Rain", "Snow", "Fog"};
             printf("Weather changing to: %s\n", weather_names[g_weather.target]);
@@ -227,9 +274,8 @@ uint32_t get_weather_sky_tint(void) {
     }
 }
 
-uint32_t apply_weather_tint(uint32_t color) {
-    uint32_t tint = get_weather_sky_tint();
-    
+// Tint a color for the given sky tint and intensity (usable off the sim thread)
+uint32_t tint_weather_color(uint32_t color, uint32_t tint, float intensity) {
     uint8_t r = ((color >> 16) & 0xFF);
     uint8_t g = ((color >> 8) & 0xFF);
     uint8_t b = ((color >> 0) & 0xFF);
@@ -244,7 +290,7 @@ uint32_t apply_weather_tint(uint32_t color) {
     b = (b * tb) / 255;
     
     // Darken based on intensity
-    float darkness = 1.0f - (g_weather.intensity * 0.3f);
+    float darkness = 1.0f - (intensity * 0.3f);
     r *= darkness;
     g *= darkness;
     b *= darkness;
@@ -252,6 +298,10 @@ uint32_t apply_weather_tint(uint32_t color) {
     return (r << 16) | (g << 8) | b;
 }
 
+uint32_t apply_weather_tint(uint32_t color) {
+    return tint_weather_color(color, get_weather_sky_tint(), g_weather.intensity);
+}
+
 // Check if it's raining
 bool is_raining(void) {
     return g_weather.current == WEATHER_RAIN || g_weather.current == WEATHER_HEAVY_RAIN;
@@ -267,57 +317,6 @@ bool is_foggy(void) {
     return g_weather.current == WEATHER_FOG;
 }
 
-// Render weather particles
-void render_weather_particles(uint8_t* framebuffer, int screen_width, int screen_height) {
-    // Render raindrops
-    for (int i = 0; i < MAX_RAINDROPS; i++) {
-        if (!g_raindrops[i].active) continue;
-        
-        int x = (int)g_raindrops[i].x;
-        int y = (int)g_raindrops[i].y;
-        int size = (int)g_raindrops[i].size;
-        
-        // Draw raindrop as vertical line
-        for (int dy = 0; dy < size * 3; dy++) {
-            int px = x;
-            int py = y + dy;
-            
-            if (px >= 0 && px < screen_width && py >= 0 && py < screen_height) {
-                int idx = (py * screen_width + px) * 4;
-                framebuffer[idx + 0] = 200;  // B
-                framebuffer[idx + 1] = 220;  // G
-                framebuffer[idx + 2] = 255;  // R
-                framebuffer[idx + 3] = 150;  // A (semi-transparent)
-            }
-        }
-    }
-    
-    // Render snowflakes
-    for (int i = 0; i < MAX_SNOWFLAKES; i++) {
-        if (!g_snowflakes[i].active) continue;
-        
-        int x = (int)g_snowflakes[i].x;
-        int y = (int)g_snowflakes[i].y;
-        int size = (int)g_snowflakes[i].size;
-        
-        // Draw snowflake as small square
-        for (int dy = -size; dy <= size; dy++) {
-            for (int dx = -size; dx <= size; dx++) {
-                int px = x + dx;
-                int py = y + dy;
-                
-                if (px >= 0 && px < screen_width && py >= 0 && py < screen_height) {
-                    int idx = (py * screen_width + px) * 4;
-                    framebuffer[idx + 0] = 255;  // B
-                    framebuffer[idx + 1] = 255;  // G
-                    framebuffer[idx + 2] = 255;  // R
-                    framebuffer[idx + 3] = 200;  // A
-                }
-            }
-        }
-    }
-}
-
 // Get weather effect on guest happiness
 int get_weather_happiness_modifier(void) {
     switch (g_weather.current) {
@@ -372,20 +371,112 @@ const char* get_weather_name(void) {
     }
 }
 
-// Save/Load support
-void save_weather_data(FILE* f) {
-    fwrite(&g_weather, sizeof(WeatherState), 1, f);
+static void copy_particle_snapshot(SnapshotParticles* dest, const ParticlePool* pool) {
+    int count = pool->count < SNAPSHOT_MAX_PARTICLES ? pool->count : SNAPSHOT_MAX_PARTICLES;
+    memcpy(dest->x, pool->x, count * sizeof(float));
+    memcpy(dest->y, pool->y, count * sizeof(float));
+    memcpy(dest->size, pool->size, count * sizeof(float));
+    dest->count = count;
 }
 
-void load_weather_data(FILE* f) {
-    fread(&g_weather, sizeof(WeatherState), 1, f);
-    
-    // Reset particles on load
-    for (int i = 0; i < MAX_RAINDROPS; i++) {
-        g_raindrops[i].active = false;
+// Copy weather state and live particles for the renderer
+void write_weather_snapshot(SimSnapshot* snap) {
+    snap->weather_name = get_weather_name();
+    snap->weather_sky_tint = get_weather_sky_tint();
+    snap->weather_intensity = g_weather.intensity;
+    snap->weather_visibility = g_weather.visibility;
+
+    copy_particle_snapshot(&snap->rain, &g_raindrops);
+    copy_particle_snapshot(&snap->snow, &g_snowflakes);
+}
+
+// Save/Load support; fields are only ever appended to this table
+static const FieldDesc g_weather_fields[] = {
+    FIELD(FIELD_U8,  WeatherState, current),
+    FIELD(FIELD_U8,  WeatherState, target),
+    FIELD(FIELD_F32, WeatherState, transition_progress),
+    FIELD(FIELD_F32, WeatherState, duration),
+    FIELD(FIELD_F32, WeatherState, next_change_timer),
+    FIELD(FIELD_F32, WeatherState, intensity),
+    FIELD(FIELD_U32, WeatherState, sky_tint),
+    FIELD(FIELD_F32, WeatherState, visibility),
+};
+
+// Live particles, one column at a time straight out of the pool
+static void save_particle_pool(SaveWriter* w, const ParticlePool* pool) {
+    write_u32(w, (uint32_t)pool->count);
+    write_f32_column(w, pool->x, pool->count);
+    write_f32_column(w, pool->y, pool->count);
+    write_f32_column(w, pool->velocity, pool->count);
+    write_f32_column(w, pool->size, pool->count);
+}
+
+static bool load_particle_pool(SaveReader* r, ParticlePool* pool) {
+    uint32_t count = read_u32(r);
+    if (!r->ok || count > (uint32_t)pool->capacity) return false;
+
+    read_f32_column(r, pool->x, count);
+    read_f32_column(r, pool->y, count);
+    read_f32_column(r, pool->velocity, count);
+    read_f32_column(r, pool->size, count);
+    pool->count = r->ok ? (int)count : 0;
+    return r->ok;
+}
+
+void save_weather_data(SaveWriter* w) {
+    size_t record = begin_record(w);
+    write_fields(w, &g_weather, g_weather_fields, NUM_FIELDS(g_weather_fields));
+    end_record(w, record);
+
+    // Version 2
+    save_particle_pool(w, &g_raindrops);
+    save_particle_pool(w, &g_snowflakes);
+}
+
+// Particles read through without keeping them
+static bool check_particle_pool(SaveReader* r, const ParticlePool* pool) {
+    uint32_t count = read_u32(r);
+    if (!r->ok || count > (uint32_t)pool->capacity) return false;
+
+    skip_bytes(r, (size_t)count * 4 * sizeof(float));
+    return r->ok;
+}
+
+static bool read_weather_state(SaveReader* r, uint16_t version, WeatherState* weather) {
+    memset(weather, 0, sizeof(*weather));
+    if (version >= 2) {
+        SaveReader record;
+        if (!read_record(r, &record)) return false;
+        read_fields(&record, weather, g_weather_fields, NUM_FIELDS(g_weather_fields));
+        r->ok = record.ok;
+    } else {
+        // Version 1 stored the same fields without a record length
+        read_fields(r, weather, g_weather_fields, NUM_FIELDS(g_weather_fields));
     }
-    for (int i = 0; i < MAX_SNOWFLAKES; i++) {
-        g_snowflakes[i].active = false;
+    return r->ok && weather->current <= WEATHER_FOG && weather->target <= WEATHER_FOG;
+}
+
+bool check_weather_data(SaveReader* r, uint16_t version) {
+    WeatherState weather;
+    if (!read_weather_state(r, version, &weather)) return false;
+    return version < 2 || (check_particle_pool(r, &g_raindrops) && check_particle_pool(r, &g_snowflakes));
+}
+
+bool load_weather_data(SaveReader* r, uint16_t version) {
+    WeatherState weather;
+    if (!read_weather_state(r, version, &weather)) {
+        printf("Invalid weather data\n");
+        return false;
+    }
+    g_weather = weather;
+
+    // Older saves carry no particles; the sky refills within a second
+    g_raindrops.count = 0;
+    g_snowflakes.count = 0;
+    if (version >= 2 && (!load_particle_pool(r, &g_raindrops) || !load_particle_pool(r, &g_snowflakes))) {
+        printf("Invalid weather particle data\n");
+        return false;
     }
+    return true;
 }
 
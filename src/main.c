@@ -5,15 +5,25 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "core/headless.h"
+#include "core/profiler.h"
+#include "core/render_target.h"
+#include "core/replay.h"
+
 // Forward declarations
-extern void init_renderer(uint8_t* framebuffer, int width, int height);
+extern void init_renderer(const RenderTarget* target);
+extern bool resize_renderer(const RenderTarget* target);
 extern void render_frame(void);
 extern void init_simulation(void);
-extern void update_simulation(float dt);
+extern bool start_simulation_thread(void);
+extern void stop_simulation_thread(void);
+extern void shutdown_particle_raster(void);
 extern void init_ui(void);
 extern void render_ui(void);
 extern void handle_mouse_click(int x, int y, int button);
 extern void handle_key_press(int key);
+extern void set_zoom_level(int zoom);
+extern int get_zoom_level(void);
 extern void move_camera(int dx, int dy);\
 extern void load_sprite_sheet(const char* filename);
 
@@ -21,20 +31,85 @@ extern void load_sprite_sheet(const char* filename);
 extern bool save_game(int slot);
 extern bool load_game(int slot);
 extern bool auto_save(void);
+extern bool start_save_thread(void);
+extern bool run_save_benchmark(void);
+extern void stop_save_thread(void);
+
+// Initial window size; the window can be resized freely afterwards
+#define DEFAULT_SCREEN_WIDTH 800
+#define DEFAULT_SCREEN_HEIGHT 600
 
-#define SCREEN_WIDTH 800
-#define SCREEN_HEIGHT 600
+// F6 saves here and journals commands against it; replay with --replay 3
+#define RECORD_SLOT 3
 
 typedef struct {
     SDL_Window* window;
     SDL_Renderer* renderer;
     SDL_Texture* texture;
-    uint8_t* framebuffer;
+    RenderTarget framebuffer;
     bool running;
 } GameState;
 
 GameState g_state = {0};
 
+// (Re)create the streaming texture and framebuffer for a window size.
+// On failure the previous pair is left in place.
+static bool create_framebuffer(int width, int height) {
+    SDL_Texture* texture = SDL_CreateTexture(
+        g_state.renderer,
+        SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STREAMING,
+        width,
+        height
+    );
+
+    if (!texture) {
+        printf("Texture creation failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    uint8_t* pixels = (uint8_t*)malloc((size_t)width * height * 4);
+    if (!pixels) {
+        printf("Framebuffer allocation failed\n");
+        SDL_DestroyTexture(texture);
+        return false;
+    }
+
+    if (g_state.texture) SDL_DestroyTexture(g_state.texture);
+    free(g_state.framebuffer.pixels);
+
+    g_state.texture = texture;
+    g_state.framebuffer.pixels = pixels;
+    g_state.framebuffer.width = width;
+    g_state.framebuffer.height = height;
+    g_state.framebuffer.pitch = width * 4;
+    return true;
+}
+
+static void handle_resize(int width, int height) {
+    if (width <= 0 || height <= 0) return;
+    if (width == g_state.framebuffer.width && height == g_state.framebuffer.height) return;
+
+    if (!create_framebuffer(width, height)) return;
+
+    if (!resize_renderer(&g_state.framebuffer)) {
+        g_state.running = false;
+        return;
+    }
+    printf("Resized to %dx%d\n", width, height);
+}
+
+// Camera changes go through here so a recording sees them
+static void scroll_camera(int dx, int dy) {
+    move_camera(dx, dy);
+    record_command(COMMAND_MOVE_CAMERA, dx, dy, 0);
+}
+
+static void change_zoom(int zoom) {
+    set_zoom_level(zoom);
+    record_command(COMMAND_SET_ZOOM, get_zoom_level(), 0, 0);
+}
+
 bool init_sdl(void) {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         printf("SDL initialization failed: %s\n", SDL_GetError());
@@ -45,9 +120,9 @@ bool init_sdl(void) {
         "RCT Clone - Assembly Edition",
         SDL_WINDOWPOS_CENTERED,
         SDL_WINDOWPOS_CENTERED,
-        SCREEN_WIDTH,
-        SCREEN_HEIGHT,
-        SDL_WINDOW_SHOWN
+        DEFAULT_SCREEN_WIDTH,
+        DEFAULT_SCREEN_HEIGHT,
+        SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE
     );
 
     if (!g_state.window) {
@@ -61,27 +136,8 @@ bool init_sdl(void) {
         return false;
     }
 
-    g_state.texture = SDL_CreateTexture(
-        g_state.renderer,
-        SDL_PIXELFORMAT_ARGB8888,
-        SDL_TEXTUREACCESS_STREAMING,
-        SCREEN_WIDTH,
-        SCREEN_HEIGHT
-    );
-
-    if (!g_state.texture) {
-        printf("Texture creation failed: %s\n", SDL_GetError());
-        return false;
-    }
-
-    // Allocate framebuffer
-    g_state.framebuffer = (uint8_t*)malloc(SCREEN_WIDTH * SCREEN_HEIGHT * 4);
-    if (!g_state.framebuffer) {
-        printf("Framebuffer allocation failed\n");
-        return false;
-    }
-
-    return true;
+    // Texture and framebuffer
+    return create_framebuffer(DEFAULT_SCREEN_WIDTH, DEFAULT_SCREEN_HEIGHT);
 }
 
 void handle_events(void) {
@@ -91,27 +147,56 @@ void handle_events(void) {
             case SDL_QUIT:
                 g_state.running = false;
                 break;
+            case SDL_WINDOWEVENT:
+                if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                    handle_resize(event.window.data1, event.window.data2);
+                }
+                break;
             case SDL_MOUSEBUTTONDOWN:
                 handle_mouse_click(event.button.x, event.button.y, event.button.button);
                 break;
+            case SDL_MOUSEWHEEL:
+                // Wheel up zooms in, wheel down zooms out
+                if (event.wheel.y > 0) {
+                    change_zoom(get_zoom_level() - 1);
+                } else if (event.wheel.y < 0) {
+                    change_zoom(get_zoom_level() + 1);
+                }
+                break;
             case SDL_KEYDOWN:
                 if (event.key.keysym.sym == SDLK_ESCAPE) {
                     g_state.running = false;
                 } else if (event.key.keysym.sym == SDLK_UP) {
-                    move_camera(0, -10);
+                    scroll_camera(0, -10);
                 } else if (event.key.keysym.sym == SDLK_DOWN) {
-                    move_camera(0, 10);
+                    scroll_camera(0, 10);
                 } else if (event.key.keysym.sym == SDLK_LEFT) {
-                    move_camera(-10, 0);
+                    scroll_camera(-10, 0);
                 } else if (event.key.keysym.sym == SDLK_RIGHT) {
-                    move_camera(10, 0);
+                    scroll_camera(10, 0);
+                } else if (event.key.keysym.sym == SDLK_PAGEUP) {
+                    change_zoom(get_zoom_level() - 1);
+                } else if (event.key.keysym.sym == SDLK_PAGEDOWN) {
+                    change_zoom(get_zoom_level() + 1);
+                } else if (event.key.keysym.sym == SDLK_F3) {
+                    toggle_profiler_overlay();
+                } else if (event.key.keysym.sym == SDLK_F4) {
+                    dump_profiler_csv("profile.csv");
                 } else if (event.key.keysym.sym == SDLK_F5) {
                     // Quick save
                     if (save_game(1)) {
                         printf("Quick saved to slot 1!\n");
                     }
+                } else if (event.key.keysym.sym == SDLK_F6) {
+                    // Toggle command recording
+                    if (is_recording()) {
+                        stop_recording();
+                    } else {
+                        start_recording(RECORD_SLOT);
+                    }
                 } else if (event.key.keysym.sym == SDLK_F9) {
-                    // Quick load
+                    // Quick load; a recording cannot follow the park across it
+                    stop_recording();
                     if (load_game(1)) {
                         printf("Quick loaded from slot 1!\n");
                     }
@@ -122,6 +207,7 @@ void handle_events(void) {
                     }
                 } else if (event.key.keysym.sym == SDLK_l && (SDL_GetModState() & KMOD_CTRL)) {
                     // Ctrl+L: Load from slot 2
+                    stop_recording();
                     if (load_game(2)) {
                         printf("Loaded from slot 2!\n");
                     }
@@ -138,28 +224,42 @@ void render(void) {
     render_frame();
 
     // Render UI on top
+    PROFILE_BEGIN(PROF_UI);
     render_ui();
+    PROFILE_END(PROF_UI);
+
+    draw_profiler_overlay(&g_state.framebuffer);
 
     // Update texture and present
-    SDL_UpdateTexture(g_state.texture, NULL, g_state.framebuffer, SCREEN_WIDTH * 4);
+    PROFILE_BEGIN(PROF_UPLOAD);
+    SDL_UpdateTexture(g_state.texture, NULL, g_state.framebuffer.pixels, g_state.framebuffer.pitch);
     SDL_RenderCopy(g_state.renderer, g_state.texture, NULL, NULL);
     SDL_RenderPresent(g_state.renderer);
+    PROFILE_END(PROF_UPLOAD);
 }
 
 void cleanup(void) {
-    if (g_state.framebuffer) free(g_state.framebuffer);
+    if (g_state.framebuffer.pixels) free(g_state.framebuffer.pixels);
     if (g_state.texture) SDL_DestroyTexture(g_state.texture);
     if (g_state.renderer) SDL_DestroyRenderer(g_state.renderer);
     if (g_state.window) SDL_DestroyWindow(g_state.window);
     SDL_Quit();
 }
 
-extern void init_sprite_system(void);
+extern bool init_sprite_system(void);
 
 
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
+    HeadlessOptions headless;
+    if (!parse_headless_args(argc, argv, &headless)) {
+        return 1;
+    }
+    if (headless.bench_save) {
+        return run_save_benchmark() ? 0 : 1;
+    }
+    if (headless.enabled) {
+        return run_headless(&headless) ? 0 : 1;
+    }
 
     printf("Initializing RCT Clone...\n");
 
@@ -169,11 +269,21 @@ int main(int argc, char* argv[]) {
     }
 
     // Initialize game systems
-    init_renderer(g_state.framebuffer, SCREEN_WIDTH, SCREEN_HEIGHT);
+    init_renderer(&g_state.framebuffer);
     init_sprite_system();
     init_simulation();
     init_ui();
 
+    // Simulation ticks on its own thread; this thread handles input and rendering
+    if (!start_simulation_thread()) {
+        cleanup();
+        return 1;
+    }
+
+    // Autosaves are written in the background; without the thread they
+    // are written synchronously instead
+    start_save_thread();
+
     g_state.running = true;
     uint64_t last_time = SDL_GetPerformanceCounter();
     const double frequency = (double)SDL_GetPerformanceFrequency();
@@ -182,7 +292,7 @@ int main(int argc, char* argv[]) {
 
     // Auto-save timer
     float autosave_timer = 0.0f;
-    const float AUTOSAVE_INTERVAL = 300.0f;  // Auto-save every 5 minutes
+    const float AUTOSAVE_INTERVAL = 30.0f;   // Journaled; every 10th is a full save
 
     while (g_state.running) {
         uint64_t current_time = SDL_GetPerformanceCounter();
@@ -190,7 +300,6 @@ int main(int argc, char* argv[]) {
         last_time = current_time;
 
         handle_events();
-        update_simulation(dt);
         render();
 
         // Auto-save periodically
@@ -206,6 +315,10 @@ int main(int argc, char* argv[]) {
     }
 
     printf("Shutting down...\n");
+    stop_recording();
+    stop_simulation_thread();
+    stop_save_thread();
+    shutdown_particle_raster();
     cleanup();
     return 0;
 }
@@ -1,6 +1,12 @@
 ; Isometric tile rendering in assembly
 ; Optimized for x86-64
 
+; RenderTarget field offsets (must match src/core/render_target.h)
+RT_PIXELS equ 0
+RT_WIDTH equ 8
+RT_HEIGHT equ 12
+RT_PITCH equ 16
+
 section .data
     tile_width equ 64
     tile_height equ 32
@@ -8,12 +14,12 @@ section .data
 section .text
     global draw_iso_tile_asm
 
-; void draw_iso_tile_asm(uint8_t* dest, int x, int y, uint32_t color, int screen_width)
-; Arguments: rdi=dest, esi=x, edx=y, ecx=color, r8d=screen_width
+; void draw_iso_tile_asm(const RenderTarget* target, int x, int y, uint32_t color)
+; Arguments: rdi=target, esi=x, edx=y, ecx=color
 draw_iso_tile_asm:
     push rbp
     mov rbp, rsp
-    sub rsp, 16
+    sub rsp, 32
     push rbx
     push r12
     push r13
@@ -21,11 +27,15 @@ draw_iso_tile_asm:
     push r15
 
     ; Save arguments
-    mov r12, rdi        ; framebuffer
+    mov r12, [rdi + RT_PIXELS]  ; framebuffer
+    mov r8d, [rdi + RT_WIDTH]   ; screen_width
+    mov eax, [rdi + RT_HEIGHT]
+    mov dword [rbp-16], eax     ; screen_height
+    mov eax, [rdi + RT_PITCH]
+    mov dword [rbp-20], eax     ; pitch (bytes)
     mov r13d, esi       ; x
     mov r14d, edx       ; y
     mov r15d, ecx       ; color (RGBA)
-    ; r8d already contains screen_width
 
     ; Extract and store color components (BGR order for ARGB8888)
     movzx eax, cl
@@ -78,7 +88,7 @@ draw_iso_tile_asm:
     ; Check if y is in bounds
     test r11d, r11d
     js .next_y
-    cmp r11d, 600       ; Screen height
+    cmp r11d, dword [rbp-16]    ; Screen height
     jge .next_y
     
     ; Draw horizontal line
@@ -99,18 +109,17 @@ draw_iso_tile_asm:
     cmp eax, r8d        ; screen_width
     jge .next_x
     
-    ; Calculate pixel offset: (y * width + x) * 4
+    ; Calculate pixel offset: y * pitch + x * 4
     push rax
     push rbx
     push rcx
     
     mov eax, r11d
-    imul eax, r8d       ; y * width
+    imul eax, dword [rbp-20]    ; y * pitch
     pop rcx
     pop rbx
     pop rdx             ; x position
-    add eax, edx        ; + x
-    shl rax, 2          ; * 4 (RGBA)
+    lea eax, [rax + rdx*4]      ; + x * 4
     
     ; Write pixel (BGRA format for SDL_PIXELFORMAT_ARGB8888)
     lea rdi, [r12 + rax]
@@ -140,6 +149,6 @@ draw_iso_tile_asm:
     pop r13
     pop r12
     pop rbx
-    add rsp, 16
+    add rsp, 32
     pop rbp
     ret
\ No newline at end of file
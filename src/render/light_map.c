@@ -0,0 +1,263 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../core/snapshot.h"
+#include "../core/render_target.h"
+
+// Low-resolution additive light map for lamps and ride lights at night.
+// Lights are accumulated into screen cells only when something that affects
+// them changes; applying the map is one SIMD multiply pass per lit run.
+
+#define LIGHT_CELL_WIDTH 16
+#define LIGHT_CELL_HEIGHT 8
+#define LIGHT_GAIN_ONE 256      // 1.0 in 8.8 fixed point
+#define LIGHT_GAIN_MAX 0x7FFF   // modulate_span_asm limit
+
+#define SCENERY_LAMP 3
+#define RIDE_STATUS_OPEN 1
+
+#define LAMP_RADIUS 80          // Pixels, horizontal (vertical is half)
+#define LAMP_INTENSITY 1.5f
+#define RIDE_LIGHT_INTENSITY 1.0f
+
+// External assembly functions
+extern void modulate_span_asm(uint8_t* dest, int count, uint64_t gains);
+
+// External renderer functions
+extern void iso_to_screen(int iso_x, int iso_y, int* screen_x, int* screen_y);
+extern int get_zoom_level(void);
+
+// External lighting functions
+extern bool are_lamps_on(void);
+extern uint32_t get_ride_lights(int ride_index);
+
+// A horizontal run of cells sharing the same gain
+typedef struct {
+    int x;
+    int count;
+    uint64_t gains;
+} LightRun;
+
+typedef struct {
+    int cells_w, cells_h;
+    float* accum;           // 3 floats (r, g, b) per cell
+    LightRun* runs;         // Up to cells_w runs per cell row
+    int* run_counts;        // Runs per cell row
+
+    // State the map was last accumulated for
+    bool valid;
+    bool lamps_on;
+    int camera_x, camera_y;
+    int zoom;
+    int screen_width, screen_height;
+    uint32_t scenery_generation;
+    uint32_t rides_generation;
+} LightMap;
+
+static LightMap g_light_map = {0};
+
+static bool resize_light_map(int screen_width, int screen_height) {
+    int cells_w = (screen_width + LIGHT_CELL_WIDTH - 1) / LIGHT_CELL_WIDTH;
+    int cells_h = (screen_height + LIGHT_CELL_HEIGHT - 1) / LIGHT_CELL_HEIGHT;
+
+    free(g_light_map.accum);
+    free(g_light_map.runs);
+    free(g_light_map.run_counts);
+
+    g_light_map.accum = (float*)malloc(cells_w * cells_h * 3 * sizeof(float));
+    g_light_map.runs = (LightRun*)malloc(cells_w * cells_h * sizeof(LightRun));
+    g_light_map.run_counts = (int*)calloc(cells_h, sizeof(int));
+
+    if (!g_light_map.accum || !g_light_map.runs || !g_light_map.run_counts) {
+        printf("Light map allocation failed\n");
+        g_light_map.cells_w = 0;
+        g_light_map.cells_h = 0;
+        return false;
+    }
+
+    g_light_map.cells_w = cells_w;
+    g_light_map.cells_h = cells_h;
+    g_light_map.screen_width = screen_width;
+    g_light_map.screen_height = screen_height;
+    return true;
+}
+
+// Add a light with quadratic falloff centered on a screen point
+static void add_light(int cx, int cy, int radius, uint32_t color, float intensity) {
+    float r = ((color >> 16) & 0xFF) / 255.0f * intensity;
+    float g = ((color >> 8) & 0xFF) / 255.0f * intensity;
+    float b = ((color >> 0) & 0xFF) / 255.0f * intensity;
+
+    int half_radius = radius / 2;  // Isometric: light pools are twice as wide as tall
+    int x0 = (cx - radius) / LIGHT_CELL_WIDTH;
+    int x1 = (cx + radius) / LIGHT_CELL_WIDTH;
+    int y0 = (cy - half_radius) / LIGHT_CELL_HEIGHT;
+    int y1 = (cy + half_radius) / LIGHT_CELL_HEIGHT;
+
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= g_light_map.cells_w) x1 = g_light_map.cells_w - 1;
+    if (y1 >= g_light_map.cells_h) y1 = g_light_map.cells_h - 1;
+
+    float inv_r2 = 1.0f / (float)(radius * radius);
+
+    for (int y = y0; y <= y1; y++) {
+        float dy = (y * LIGHT_CELL_HEIGHT + LIGHT_CELL_HEIGHT / 2 - cy) * 2.0f;
+        for (int x = x0; x <= x1; x++) {
+            float dx = (float)(x * LIGHT_CELL_WIDTH + LIGHT_CELL_WIDTH / 2 - cx);
+            float falloff = 1.0f - (dx * dx + dy * dy) * inv_r2;
+            if (falloff <= 0.0f) continue;
+
+            float* cell = &g_light_map.accum[(y * g_light_map.cells_w + x) * 3];
+            cell[0] += r * falloff;
+            cell[1] += g * falloff;
+            cell[2] += b * falloff;
+        }
+    }
+}
+
+static uint64_t gain_from_light(float light) {
+    int gain = LIGHT_GAIN_ONE + (int)(light * LIGHT_GAIN_ONE);
+    if (gain > LIGHT_GAIN_MAX) gain = LIGHT_GAIN_MAX;
+    return (uint64_t)gain;
+}
+
+// Collapse accumulated light into runs of equal gain per cell row
+static void build_light_runs(void) {
+    for (int y = 0; y < g_light_map.cells_h; y++) {
+        LightRun* runs = &g_light_map.runs[y * g_light_map.cells_w];
+        int count = 0;
+
+        for (int x = 0; x < g_light_map.cells_w; x++) {
+            float* cell = &g_light_map.accum[(y * g_light_map.cells_w + x) * 3];
+            uint64_t r = gain_from_light(cell[0]);
+            uint64_t g = gain_from_light(cell[1]);
+            uint64_t b = gain_from_light(cell[2]);
+
+            if (r == LIGHT_GAIN_ONE && g == LIGHT_GAIN_ONE && b == LIGHT_GAIN_ONE) {
+                continue;
+            }
+
+            uint64_t gains = b | (g << 16) | (r << 32) | ((uint64_t)LIGHT_GAIN_ONE << 48);
+
+            if (count > 0 && runs[count - 1].gains == gains &&
+                runs[count - 1].x + runs[count - 1].count == x) {
+                runs[count - 1].count++;
+            } else {
+                runs[count].x = x;
+                runs[count].count = 1;
+                runs[count].gains = gains;
+                count++;
+            }
+        }
+
+        g_light_map.run_counts[y] = count;
+    }
+}
+
+static void accumulate_lights(const SimSnapshot* snap) {
+    int zoom = g_light_map.zoom;
+
+    memset(g_light_map.accum, 0, g_light_map.cells_w * g_light_map.cells_h * 3 * sizeof(float));
+
+    // Street lamps
+    for (int i = 0; i < snap->num_scenery; i++) {
+        if (snap->scenery[i].type != SCENERY_LAMP) continue;
+
+        int screen_x, screen_y;
+        iso_to_screen(snap->scenery[i].x, snap->scenery[i].y, &screen_x, &screen_y);
+        add_light(screen_x, screen_y - (12 >> zoom), LAMP_RADIUS >> zoom, 0xFFF2B3, LAMP_INTENSITY);
+    }
+
+    // Open rides light up their footprint
+    for (int i = 0; i < snap->num_rides; i++) {
+        const SnapshotRide* ride = &snap->rides[i];
+        if (!ride->active || ride->status != RIDE_STATUS_OPEN) continue;
+
+        int rw = ride->width;
+        int rh = ride->height;
+
+        // Center of the footprint diamond
+        int screen_x, screen_y;
+        iso_to_screen(ride->x, ride->y, &screen_x, &screen_y);
+        screen_x += ((rw - rh) * 16 + 32) >> zoom;
+        screen_y += ((rw + rh) * 8) >> zoom;
+
+        int size = (rw > rh) ? rw : rh;
+        add_light(screen_x, screen_y, (48 + size * 24) >> zoom, get_ride_lights(i), RIDE_LIGHT_INTENSITY);
+    }
+
+    build_light_runs();
+}
+
+// Re-accumulate the light map if lights moved, toggled or the view changed
+void update_light_map(const SimSnapshot* snap, int camera_x, int camera_y, int screen_width, int screen_height) {
+    bool lamps_on = are_lamps_on();
+    int zoom = get_zoom_level();
+
+    if (screen_width != g_light_map.screen_width || screen_height != g_light_map.screen_height) {
+        if (!resize_light_map(screen_width, screen_height)) return;
+        g_light_map.valid = false;
+    }
+
+    uint32_t scenery_generation = snap->scenery_generation;
+    uint32_t rides_generation = snap->rides_generation;
+
+    if (g_light_map.valid &&
+        lamps_on == g_light_map.lamps_on &&
+        camera_x == g_light_map.camera_x &&
+        camera_y == g_light_map.camera_y &&
+        zoom == g_light_map.zoom &&
+        scenery_generation == g_light_map.scenery_generation &&
+        rides_generation == g_light_map.rides_generation) {
+        return;
+    }
+
+    g_light_map.lamps_on = lamps_on;
+    g_light_map.camera_x = camera_x;
+    g_light_map.camera_y = camera_y;
+    g_light_map.zoom = zoom;
+    g_light_map.scenery_generation = scenery_generation;
+    g_light_map.rides_generation = rides_generation;
+    g_light_map.valid = true;
+
+    // Nothing to accumulate during the day
+    if (!lamps_on) {
+        for (int y = 0; y < g_light_map.cells_h; y++) {
+            g_light_map.run_counts[y] = 0;
+        }
+        return;
+    }
+
+    accumulate_lights(snap);
+}
+
+// Multiply the framebuffer by the light map (no-op when nothing is lit)
+void apply_light_map(const RenderTarget* target) {
+    if (!g_light_map.valid || !g_light_map.lamps_on) return;
+    if (target->width != g_light_map.screen_width || target->height != g_light_map.screen_height) return;
+
+    for (int cy = 0; cy < g_light_map.cells_h; cy++) {
+        int count = g_light_map.run_counts[cy];
+        if (count == 0) continue;
+
+        LightRun* runs = &g_light_map.runs[cy * g_light_map.cells_w];
+        int y_end = (cy + 1) * LIGHT_CELL_HEIGHT;
+        if (y_end > target->height) y_end = target->height;
+
+        for (int y = cy * LIGHT_CELL_HEIGHT; y < y_end; y++) {
+            uint8_t* line = render_target_pixel(target, 0, y);
+
+            for (int i = 0; i < count; i++) {
+                int x = runs[i].x * LIGHT_CELL_WIDTH;
+                int width = runs[i].count * LIGHT_CELL_WIDTH;
+                if (x + width > target->width) width = target->width - x;
+
+                modulate_span_asm(line + x * 4, width, runs[i].gains);
+            }
+        }
+    }
+}
@@ -1,4 +1,6 @@
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <stdbool.h>
 
@@ -15,6 +17,15 @@ typedef struct {
 
 static LightingState g_lighting = {0};
 
+// Per-channel brightness lookup, rebuilt when ambient brightness changes
+static uint8_t g_light_lut[256];
+static float g_light_lut_brightness = -1.0f;
+
+// Sky gradient cache (one ARGB color per screen row)
+static uint32_t* g_sky_rows = NULL;
+static int g_sky_rows_height = 0;
+static bool g_sky_rows_dirty = true;
+
 // Get sky gradient colors based on time of day
 void calculate_sky_color(float time_of_day, Color* top, Color* bottom) {
     // time_of_day is 0.0-24.0 (hours)
@@ -84,13 +95,38 @@ float calculate_ambient_brightness(float time_of_day) {
 }
 
 void update_lighting(float time_of_day) {
-    calculate_sky_color(time_of_day, &g_lighting.sky_top, &g_lighting.sky_bottom);
+    Color top, bottom;
+    calculate_sky_color(time_of_day, &top, &bottom);
+
+    // Only rebuild the sky rows when the gradient actually changes
+    if (memcmp(&top, &g_lighting.sky_top, sizeof(Color)) != 0 ||
+        memcmp(&bottom, &g_lighting.sky_bottom, sizeof(Color)) != 0) {
+        g_lighting.sky_top = top;
+        g_lighting.sky_bottom = bottom;
+        g_sky_rows_dirty = true;
+    }
     g_lighting.ambient_brightness  = calculate_ambient_brightness(time_of_day);
 
+    if (g_lighting.ambient_brightness != g_light_lut_brightness) {
+        float brightness = g_lighting.ambient_brightness;
+        if (brightness > 1.0f) brightness = 1.0f;
+
+        for (int i = 0; i < 256; i++) {
+            g_light_lut[i] = (uint8_t)(i * brightness);
+        }
+        g_light_lut_brightness = g_lighting.ambient_brightness;
+    }
+
     g_lighting.lamps_on = (time_of_day < 6.0f || time_of_day >= 18.0f);
 }
 
 uint32_t apply_lighting(uint32_t color, float additional_brightness) {
+    if (additional_brightness == 0.0f) {
+        return (g_light_lut[(color >> 16) & 0xFF] << 16) |
+               (g_light_lut[(color >> 8) & 0xFF] << 8) |
+               g_light_lut[color & 0xFF];
+    }
+
     float brightness = g_lighting.ambient_brightness + additional_brightness;
     if (brightness > 1.0f) brightness = 1.0f;
 
@@ -111,6 +147,32 @@ uint32_t get_sky_color(int screen_y, int screen_height) {
     return (r << 16) | (g << 8) | b;
 }
 
+// Get the cached sky gradient, one color per row
+const uint32_t* get_sky_rows(int screen_height) {
+    if (screen_height <= 0) {
+        return NULL;
+    }
+
+    if (screen_height != g_sky_rows_height) {
+        uint32_t* rows = (uint32_t*)realloc(g_sky_rows, screen_height * sizeof(uint32_t));
+        if (!rows) {
+            return NULL;
+        }
+        g_sky_rows = rows;
+        g_sky_rows_height = screen_height;
+        g_sky_rows_dirty = true;
+    }
+
+    if (g_sky_rows_dirty) {
+        for (int y = 0; y < screen_height; y++) {
+            g_sky_rows[y] = 0xFF000000 | get_sky_color(y, screen_height);
+        }
+        g_sky_rows_dirty = false;
+    }
+
+    return g_sky_rows;
+}
+
 bool are_lamps_on(void) {
     return g_lighting.lamps_on;
 }
@@ -0,0 +1,187 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../core/snapshot.h"
+#include "../core/render_target.h"
+
+// External assembly functions
+extern void blend_span_asm(uint8_t* dest, int count, uint32_t color, int alpha);
+extern void blend_column_asm(uint8_t* dest, int count, uint32_t color, int alpha, int pitch);
+
+#define RAIN_COLOR 0xFFDCC8         // Pale blue-white streak
+#define RAIN_ALPHA 150
+#define RAIN_LENGTH 3               // Streak length per unit of drop size
+#define SNOW_COLOR 0xFFFFFF
+#define SNOW_ALPHA 200
+
+#define MAX_RASTER_WORKERS 4
+#define MIN_PARALLEL_PARTICLES 256  // Fewer than this are drawn on the render thread alone
+
+// The screen is split into horizontal bands, one per worker plus one for the
+// render thread. Every band walks all particles but only touches its own rows,
+// so bands never share pixels and the result does not depend on the split.
+typedef struct {
+    const SimSnapshot* snap;
+    const RenderTarget* target;
+    int top, bottom;                // Rows [top, bottom)
+} RasterBand;
+
+typedef struct {
+    SDL_Thread* thread;
+    SDL_sem* start;
+    RasterBand band;
+} RasterWorker;
+
+static RasterWorker g_workers[MAX_RASTER_WORKERS];
+static int g_num_workers = 0;
+static SDL_sem* g_band_done = NULL;
+static SDL_atomic_t g_workers_running;
+
+static void draw_rain_band(const RasterBand* band) {
+    const SnapshotParticles* rain = &band->snap->rain;
+    const RenderTarget* target = band->target;
+
+    for (int i = 0; i < rain->count; i++) {
+        int x = (int)rain->x[i];
+        if (x < 0 || x >= target->width) continue;
+
+        // Vertical streak, clipped to the band once
+        int y0 = (int)rain->y[i];
+        int y1 = y0 + (int)rain->size[i] * RAIN_LENGTH;
+        if (y0 < band->top) y0 = band->top;
+        if (y1 > band->bottom) y1 = band->bottom;
+        if (y0 >= y1) continue;
+
+        blend_column_asm(render_target_pixel(target, x, y0), y1 - y0,
+                         RAIN_COLOR, RAIN_ALPHA, target->pitch);
+    }
+}
+
+static void draw_snow_band(const RasterBand* band) {
+    const SnapshotParticles* snow = &band->snap->snow;
+    const RenderTarget* target = band->target;
+
+    for (int i = 0; i < snow->count; i++) {
+        int x = (int)snow->x[i];
+        int y = (int)snow->y[i];
+        int size = (int)snow->size[i];
+
+        // Square flake of side 2 * size + 1 centred on the particle
+        int x0 = x - size;
+        int x1 = x + size + 1;
+        int y0 = y - size;
+        int y1 = y + size + 1;
+        if (x0 < 0) x0 = 0;
+        if (x1 > target->width) x1 = target->width;
+        if (y0 < band->top) y0 = band->top;
+        if (y1 > band->bottom) y1 = band->bottom;
+        if (x0 >= x1 || y0 >= y1) continue;
+
+        uint8_t* row = render_target_pixel(target, x0, y0);
+        for (int py = y0; py < y1; py++) {
+            blend_span_asm(row, x1 - x0, SNOW_COLOR, SNOW_ALPHA);
+            row += target->pitch;
+        }
+    }
+}
+
+static void draw_band(const RasterBand* band) {
+    draw_rain_band(band);
+    draw_snow_band(band);
+}
+
+static int raster_worker(void* data) {
+    RasterWorker* worker = (RasterWorker*)data;
+
+    while (true) {
+        SDL_SemWait(worker->start);
+        if (!SDL_AtomicGet(&g_workers_running)) break;
+
+        draw_band(&worker->band);
+        SDL_SemPost(g_band_done);
+    }
+
+    return 0;
+}
+
+void init_particle_raster(void) {
+    if (g_band_done) return;
+
+    // Leave a core each for the render and simulation threads
+    int workers = SDL_GetCPUCount() - 2;
+    if (workers > MAX_RASTER_WORKERS) workers = MAX_RASTER_WORKERS;
+    if (workers <= 0) return;
+
+    g_band_done = SDL_CreateSemaphore(0);
+    if (!g_band_done) {
+        printf("Particle raster semaphore creation failed: %s\n", SDL_GetError());
+        return;
+    }
+
+    SDL_AtomicSet(&g_workers_running, 1);
+    for (int i = 0; i < workers; i++) {
+        RasterWorker* worker = &g_workers[g_num_workers];
+        worker->start = SDL_CreateSemaphore(0);
+        if (!worker->start) break;
+
+        worker->thread = SDL_CreateThread(raster_worker, "particles", worker);
+        if (!worker->thread) {
+            SDL_DestroySemaphore(worker->start);
+            break;
+        }
+        g_num_workers++;
+    }
+
+    printf("Particle raster using %d worker thread(s)\n", g_num_workers);
+}
+
+void shutdown_particle_raster(void) {
+    SDL_AtomicSet(&g_workers_running, 0);
+    for (int i = 0; i < g_num_workers; i++) {
+        SDL_SemPost(g_workers[i].start);
+        SDL_WaitThread(g_workers[i].thread, NULL);
+        SDL_DestroySemaphore(g_workers[i].start);
+    }
+    g_num_workers = 0;
+
+    if (g_band_done) {
+        SDL_DestroySemaphore(g_band_done);
+        g_band_done = NULL;
+    }
+}
+
+// Render weather particles from a simulation snapshot
+void render_weather_particles(const SimSnapshot* snap, const RenderTarget* target) {
+    int total = snap->rain.count + snap->snow.count;
+    if (total == 0) return;
+
+    int screen_height = target->height;
+    RasterBand whole = { snap, target, 0, screen_height };
+    if (g_num_workers == 0 || total < MIN_PARALLEL_PARTICLES) {
+        draw_band(&whole);
+        return;
+    }
+
+    // Workers take the upper bands, the render thread takes the last one
+    int bands = g_num_workers + 1;
+    int band_height = (screen_height + bands - 1) / bands;
+    for (int i = 0; i < g_num_workers; i++) {
+        RasterBand* band = &g_workers[i].band;
+        *band = whole;
+        band->top = i * band_height;
+        band->bottom = (i + 1) * band_height;
+        if (band->bottom > screen_height) band->bottom = screen_height;
+        SDL_SemPost(g_workers[i].start);
+    }
+
+    whole.top = g_num_workers * band_height;
+    if (whole.top < screen_height) {
+        draw_band(&whole);
+    }
+
+    for (int i = 0; i < g_num_workers; i++) {
+        SDL_SemWait(g_band_done);
+    }
+}
@@ -5,251 +5,554 @@
 #include <math.h>
 #include <stdio.h>
 
-// External assembly functions
-extern void draw_iso_tile_asm(uint8_t* dest, int x, int y, uint32_t color, int screen_width);
-extern void fill_rect_asm(uint8_t* dest, int x, int y, int width, int height, uint32_t color, int screen_width);
-
-// External getters from simulation
-extern int get_num_guests(void);
-extern void get_guest_position(int index, float* x, float* y);
-extern uint32_t get_guest_color(int index);
-
-// External ride functions
-extern int get_num_rides(void);
-extern void get_ride_info(int idx, int* x, int* y, int* width, int* height, int* status);
-
-// External staff functions
-extern int get_num_staff(void);
-extern void get_staff_position(int index, float* x, float* y);
-extern int get_staff_type(int index);
-
-// External scenery functions
-extern int get_num_scenery(void);
-extern void get_scenery_info(int idx, int* x, int* y, int* type, uint32_t* color);
-
-// External shop functions
-extern int get_num_shops(void);
-extern void get_shop_info(int idx, int* x, int* y, int* type);
+#include "../game/map.h"
+#include "../core/snapshot.h"
+#include "../core/profiler.h"
+#include "../core/render_target.h"
 
-// External litter functions
-extern int get_num_litter(void);
-extern void get_litter_position(int idx, float* x, float* y);
+// External assembly functions
+extern void fill_rect_asm(const RenderTarget* target, int x, int y, int width, int height, uint32_t color);
+extern void fill_span_asm(uint8_t* dest, int count, uint32_t color);
 
 // External lighting functions
 extern void update_lighting(float time_of_day);
 extern uint32_t apply_lighting(uint32_t color, float additional_brightness);
-extern uint32_t get_sky_color(int screen_y, int screen_height);
+extern const uint32_t* get_sky_rows(int screen_height);
 extern bool are_lamps_on(void);
 extern uint32_t get_lamp_glow_color(void);
-extern uint32_t get_ride_lights(int ride_index);
-
-// External time function
-extern float get_time_of_day(void);
+extern void update_light_map(const SimSnapshot* snap, int camera_x, int camera_y, int screen_width, int screen_height);
+extern void apply_light_map(const RenderTarget* target);
+extern float get_ambient_brightness(void);
 
 // External weather functions
-extern void render_weather_particles(uint8_t* framebuffer, int screen_width, int screen_height);
-extern uint32_t apply_weather_tint(uint32_t color);
-extern float get_weather_visibility(void);
-extern const char* get_weather_name(void);
+extern void init_particle_raster(void);
+extern void render_weather_particles(const SimSnapshot* snap, const RenderTarget* target);
+extern void set_weather_view_size(int width, int height);
+extern uint32_t tint_weather_color(uint32_t color, uint32_t tint, float intensity);
 
-// Forward declare UI framebuffer setter
-extern void set_ui_framebuffer(uint8_t* fb);
+// Forward declare UI render target setter
+extern void set_ui_target(const RenderTarget* target);
 
-#define MAP_SIZE 32
 #define TILE_WIDTH 64
 #define TILE_HEIGHT 32
+#define TILE_HEIGHT_STEP 8     // Pixels per terrain height unit at 1x
+#define NUM_ZOOM_LEVELS 3      // 1x, 1/2, 1/4
+#define MAX_COVERAGE_SPANS 8
+#define COLOR_CACHE_SIZE 256
+#define MAX_SHADE_LEVEL 8      // Height darkening bottoms out at this level
+
+// Color transform flags (part of the cache key)
+#define COLOR_WEATHER 0x10000000
 
 typedef struct {
-    uint8_t* framebuffer;
-    int screen_width;
-    int screen_height;
+    RenderTarget target;
     int camera_x;
     int camera_y;
+    int zoom;              // 0 = 1x, 1 = 1/2, 2 = 1/4
 } Renderer;
 
+// Tile diamond pre-scaled for one zoom level: one span per row
+typedef struct {
+    int tile_width;
+    int tile_height;
+    int height_step;
+    int16_t row_offset[TILE_HEIGHT];
+    int16_t row_width[TILE_HEIGHT];
+} ZoomLevel;
+
+// Terrain tile that survived chunk culling this frame
 typedef struct {
+    int screen_x, screen_y;
     uint8_t height;
-    uint8_t type;  // 0=grass, 1=path, 2=ride
-} Tile;
+    uint8_t type;
+} VisibleTile;
+
+// Terrain coverage for one screen row: disjoint [x0, x1) spans.
+// count == -1 means the row overflowed and must be treated as uncovered.
+typedef struct {
+    int count;
+    int16_t spans[MAX_COVERAGE_SPANS][2];
+} CoverageRow;
+
+// Memoized base color -> lit/tinted color
+typedef struct {
+    uint32_t key;
+    uint32_t color;
+    uint32_t generation;
+} ColorCacheEntry;
+
+typedef struct {
+    ColorCacheEntry entries[COLOR_CACHE_SIZE];
+    uint32_t generation;
+    float brightness;
+    uint32_t weather_tint;
+    float weather_intensity;
+} ColorCache;
 
 static Renderer g_renderer = {0};
-static Tile g_map[MAP_SIZE][MAP_SIZE] = {0};
+static ZoomLevel g_zoom_levels[NUM_ZOOM_LEVELS];
+static CoverageRow* g_coverage = NULL;
+static ColorCache g_color_cache = {0};
+
+// Per-frame chunk visibility and the tiles it lets through
+static uint8_t* g_visible_chunks = NULL;
+static int g_visible_chunks_capacity = 0;
+static VisibleTile* g_visible_tiles = NULL;
+static int g_num_visible_tiles = 0;
+static int g_visible_tiles_capacity = 0;
+
+// Scale the tile diamond down once per zoom level
+static void build_zoom_levels(void) {
+    for (int z = 0; z < NUM_ZOOM_LEVELS; z++) {
+        ZoomLevel* level = &g_zoom_levels[z];
+        level->tile_width = TILE_WIDTH >> z;
+        level->tile_height = TILE_HEIGHT >> z;
+        level->height_step = TILE_HEIGHT_STEP >> z;
 
-void init_renderer(uint8_t* framebuffer, int width, int height) {
+        for (int row = 0; row < level->tile_height; row++) {
+            int dy = abs(row - level->tile_height / 2);
+            level->row_offset[row] = (int16_t)dy;
+            level->row_width[row] = (int16_t)(level->tile_width - dy * 2);
+        }
+    }
+}
+
+// Point the renderer, UI and weather at a framebuffer of any size
+static bool set_render_target(const RenderTarget* target) {
+    // Per-row terrain coverage used to skip sky pixels under the map
+    CoverageRow* coverage = (CoverageRow*)realloc(g_coverage, target->height * sizeof(CoverageRow));
+    if (!coverage) {
+        printf("Failed to allocate terrain coverage for %dx%d\n", target->width, target->height);
+        g_renderer.target.pixels = NULL;
+        return false;
+    }
+    g_coverage = coverage;
+    g_renderer.target = *target;
+    
+    // Set render target for UI system as well
+    set_ui_target(target);
+    
+    // Rain and snow spawn across and fall through the visible area
+    set_weather_view_size(target->width, target->height);
+    return true;
+}
+
+void init_renderer(const RenderTarget* target) {
     printf("init_renderer: framebuffer=%p, width=%d, height=%d\n", 
-           (void*)framebuffer, width, height);
+           (void*)target->pixels, target->width, target->height);
     
-    g_renderer.framebuffer = framebuffer;
-    g_renderer.screen_width = width;
-    g_renderer.screen_height = height;
     g_renderer.camera_x = 0;
     g_renderer.camera_y = 0;
+    g_renderer.zoom = 0;
+
+    build_zoom_levels();
+    set_render_target(target);
     
-    // Set framebuffer for UI system as well
-    set_ui_framebuffer(framebuffer);
-
-    // Initialize a more interesting test map
-    for (int y = 0; y < MAP_SIZE; y++) {
-        for (int x = 0; x < MAP_SIZE; x++) {
-            g_map[y][x].height = 0;
-            g_map[y][x].type = 0;
-            
-            // Create a winding path
-            if ((x == 5 && y >= 5 && y <= 25) || 
-                (y == 25 && x >= 5 && x <= 15) ||
-                (x == 15 && y >= 10 && y <= 25) ||
-                (y == 10 && x >= 15 && x <= 25)) {
-                g_map[y][x].type = 1; // path
-            }
-            
-            // Create some hills
-            int dx = x - 20;
-            int dy = y - 20;
-            float dist = sqrtf(dx*dx + dy*dy);
-            if (dist < 5) {
-                g_map[y][x].height = (int)(3 - dist * 0.6f);
-            }
-            
-            // Create a flat area for rides
-            if (x >= 8 && x <= 12 && y >= 8 && y <= 12) {
-                g_map[y][x].height = 0;
-                if (x == 10 && y == 10) {
-                    g_map[y][x].type = 2; // ride
-                }
-            }
-        }
-    }
+    // Band workers for rain and snow
+    init_particle_raster();
+}
+
+// Switch to a resized framebuffer, keeping the view centred on the same spot
+bool resize_renderer(const RenderTarget* target) {
+    // Horizontal centring is built into iso_to_screen; the map origin is
+    // anchored to the top edge, so shift the camera by half the height change
+    g_renderer.camera_y += g_renderer.target.height / 2 - target->height / 2;
+    return set_render_target(target);
 }
 
 // Convert isometric coordinates to screen coordinates
 void iso_to_screen(int iso_x, int iso_y, int* screen_x, int* screen_y) {
-    *screen_x = (iso_x - iso_y) * (TILE_WIDTH / 2) + g_renderer.screen_width / 2 - g_renderer.camera_x;
-    *screen_y = (iso_x + iso_y) * (TILE_HEIGHT / 2) + 100 - g_renderer.camera_y;
+    const ZoomLevel* level = &g_zoom_levels[g_renderer.zoom];
+    *screen_x = (iso_x - iso_y) * (level->tile_width / 2) + g_renderer.target.width / 2 - g_renderer.camera_x;
+    *screen_y = (iso_x + iso_y) * (level->tile_height / 2) + 100 - g_renderer.camera_y;
 }
 
 // Convert screen coordinates to isometric tile coordinates
 void screen_to_iso(int screen_x, int screen_y, int* iso_x, int* iso_y) {
     // Adjust for camera
-    screen_x += g_renderer.camera_x - g_renderer.screen_width / 2;
+    screen_x += g_renderer.camera_x - g_renderer.target.width / 2;
     screen_y += g_renderer.camera_y - 100;
     
     // Convert from screen to isometric
-    float fx = screen_x / (float)(TILE_WIDTH / 2);
-    float fy = screen_y / (float)(TILE_HEIGHT / 2);
+    const ZoomLevel* level = &g_zoom_levels[g_renderer.zoom];
+    float fx = screen_x / (float)(level->tile_width / 2);
+    float fy = screen_y / (float)(level->tile_height / 2);
     
     *iso_x = (int)((fx + fy) / 2.0f);
     *iso_y = (int)((fy - fx) / 2.0f);
 }
 
+// Screen position of a tile's top-left corner, including its height offset
+static void tile_screen_pos(int map_x, int map_y, int* screen_x, int* screen_y) {
+    iso_to_screen(map_x, map_y, screen_x, screen_y);
+    *screen_y -= get_tile_height(map_x, map_y) * g_zoom_levels[g_renderer.zoom].height_step;
+}
+
+// Scale an entity offset or size drawn at 1x to the current zoom level
+static int zoom_scale(int value) {
+    int scaled = value >> g_renderer.zoom;
+    if (value > 0 && scaled == 0) scaled = 1;
+    return scaled;
+}
+
+// Draw an entity rectangle given in 1x units relative to its anchor
+static void draw_zoomed_rect(int anchor_x, int anchor_y, int dx, int dy,
+                             int width, int height, uint32_t color) {
+    fill_rect_asm(&g_renderer.target, anchor_x + zoom_scale(dx), anchor_y + zoom_scale(dy),
+                  zoom_scale(width), zoom_scale(height), color);
+}
+
+// Draw one terrain diamond from the current zoom level's span table
+static void draw_tile(int screen_x, int screen_y, uint32_t color) {
+    const ZoomLevel* level = &g_zoom_levels[g_renderer.zoom];
+    int width = g_renderer.target.width;
+    int height = g_renderer.target.height;
+
+    if (screen_y >= height || screen_y + level->tile_height <= 0) return;
+    if (screen_x >= width || screen_x + level->tile_width <= 0) return;
+
+    uint32_t pixel = 0xFF000000 | color;
+
+    for (int row = 0; row < level->tile_height; row++) {
+        int py = screen_y + row;
+        if (py < 0) continue;
+        if (py >= height) break;
+
+        int x0 = screen_x + level->row_offset[row];
+        int x1 = x0 + level->row_width[row];
+        if (x0 < 0) x0 = 0;
+        if (x1 > width) x1 = width;
+        if (x0 >= x1) continue;
+
+        fill_span_asm(render_target_pixel(&g_renderer.target, x0, py), x1 - x0, pixel);
+    }
+}
+
+// Check whether any part of a chunk (including raised tiles and entities) is on screen
+static bool is_chunk_visible(int cx, int cy) {
+    int x0 = cx * CHUNK_SIZE;
+    int y0 = cy * CHUNK_SIZE;
+    int x1 = x0 + CHUNK_SIZE;
+    int y1 = y0 + CHUNK_SIZE;
+    int margin = 16;  // Guests and scenery stick out above their tile
+
+    int left, right, top, bottom, unused;
+    iso_to_screen(x0, y1, &left, &unused);
+    iso_to_screen(x1, y0, &right, &unused);
+    iso_to_screen(x0, y0, &unused, &top);
+    iso_to_screen(x1, y1, &unused, &bottom);
+
+    const ZoomLevel* level = &g_zoom_levels[g_renderer.zoom];
+    top -= get_map_chunk_max_height(cx, cy) * level->height_step + margin;
+    right += level->tile_width;
+    bottom += level->tile_height;
+
+    return right > 0 && left < g_renderer.target.width &&
+           bottom > 0 && top < g_renderer.target.height;
+}
+
+// Cull chunks against the screen and gather the visible terrain in draw order
+static void collect_visible_tiles(void) {
+    int chunks_x = get_map_chunks_x();
+    int chunks_y = get_map_chunks_y();
+    int num_chunks = chunks_x * chunks_y;
+
+    if (num_chunks > g_visible_chunks_capacity) {
+        uint8_t* chunks = (uint8_t*)realloc(g_visible_chunks, num_chunks);
+        if (!chunks) return;
+        g_visible_chunks = chunks;
+        g_visible_chunks_capacity = num_chunks;
+    }
+
+    for (int cy = 0; cy < chunks_y; cy++) {
+        for (int cx = 0; cx < chunks_x; cx++) {
+            g_visible_chunks[cy * chunks_x + cx] = is_chunk_visible(cx, cy);
+        }
+    }
+
+    int map_w = get_map_width();
+    int map_h = get_map_height();
+    int height_step = g_zoom_levels[g_renderer.zoom].height_step;
+    g_num_visible_tiles = 0;
+
+    // Row-major over the whole map so overlapping raised tiles still draw back to front
+    for (int cy = 0; cy < chunks_y; cy++) {
+        for (int ty = 0; ty < CHUNK_SIZE; ty++) {
+            int map_y = cy * CHUNK_SIZE + ty;
+            if (map_y >= map_h) break;
+
+            for (int cx = 0; cx < chunks_x; cx++) {
+                if (!g_visible_chunks[cy * chunks_x + cx]) continue;
+
+                for (int tx = 0; tx < CHUNK_SIZE; tx++) {
+                    int map_x = cx * CHUNK_SIZE + tx;
+                    if (map_x >= map_w) break;
+
+                    if (g_num_visible_tiles == g_visible_tiles_capacity) {
+                        int capacity = g_visible_tiles_capacity ? g_visible_tiles_capacity * 2 : 1024;
+                        VisibleTile* tiles = (VisibleTile*)realloc(g_visible_tiles, capacity * sizeof(VisibleTile));
+                        if (!tiles) return;
+                        g_visible_tiles = tiles;
+                        g_visible_tiles_capacity = capacity;
+                    }
+
+                    VisibleTile* tile = &g_visible_tiles[g_num_visible_tiles++];
+                    tile->height = get_tile_height(map_x, map_y);
+                    tile->type = get_tile_type(map_x, map_y);
+                    iso_to_screen(map_x, map_y, &tile->screen_x, &tile->screen_y);
+                    tile->screen_y -= tile->height * height_step;
+                }
+            }
+        }
+    }
+}
+
+static bool is_chunk_visible_cached(int cx, int cy) {
+    return g_visible_chunks[cy * get_map_chunks_x() + cx];
+}
+
+// Entities are culled by the chunk they stand in
+static bool is_entity_visible(float x, float y) {
+    int cx = (int)x / CHUNK_SIZE;
+    int cy = (int)y / CHUNK_SIZE;
+    if (x < 0.0f || y < 0.0f || cx >= get_map_chunks_x() || cy >= get_map_chunks_y()) {
+        return false;
+    }
+    return is_chunk_visible_cached(cx, cy);
+}
+
+// Invalidate the color cache if lighting or weather changed since last frame
+static void refresh_color_cache(const SimSnapshot* snap) {
+    float brightness = get_ambient_brightness();
+    uint32_t tint = snap->weather_sky_tint;
+    float intensity = snap->weather_intensity;
+
+    if (g_color_cache.generation == 0 ||
+        brightness != g_color_cache.brightness ||
+        tint != g_color_cache.weather_tint ||
+        intensity != g_color_cache.weather_intensity) {
+        g_color_cache.generation++;
+        g_color_cache.brightness = brightness;
+        g_color_cache.weather_tint = tint;
+        g_color_cache.weather_intensity = intensity;
+    }
+}
+
+// Height shading, lighting and (optionally) weather tint in one lookup.
+// shade is the tile height clamped to MAX_SHADE_LEVEL.
+static uint32_t shade_color(uint32_t color, int shade, uint32_t flags) {
+    uint32_t key = (color & 0xFFFFFF) | ((uint32_t)shade << 24) | flags;
+    ColorCacheEntry* entry = &g_color_cache.entries[(key * 2654435761u) >> 24];
+
+    if (entry->generation == g_color_cache.generation && entry->key == key) {
+        return entry->color;
+    }
+
+    uint32_t result = color;
+
+    // Darken based on height for depth effect
+    if (shade > 0) {
+        int brightness = 255 - (shade * 20);
+        if (brightness < 100) brightness = 100;
+
+        uint8_t r = ((result >> 16) & 0xFF) * brightness / 255;
+        uint8_t g = ((result >> 8) & 0xFF) * brightness / 255;
+        uint8_t b = ((result >> 0) & 0xFF) * brightness / 255;
+        result = (r << 16) | (g << 8) | b;
+    }
+
+    result = apply_lighting(result, 0.0f);
+
+    if (flags & COLOR_WEATHER) {
+        result = tint_weather_color(result, g_color_cache.weather_tint,
+                                    g_color_cache.weather_intensity);
+    }
+
+    entry->key = key;
+    entry->color = result;
+    entry->generation = g_color_cache.generation;
+    return result;
+}
+
+// Merge [x0, x1) into a row's coverage
+static void coverage_add_span(CoverageRow* row, int x0, int x1) {
+    if (row->count < 0) return;
+
+    // Absorb every span that overlaps or touches the new one
+    int i = 0;
+    while (i < row->count) {
+        if (x1 < row->spans[i][0] || x0 > row->spans[i][1]) {
+            i++;
+            continue;
+        }
+        if (row->spans[i][0] < x0) x0 = row->spans[i][0];
+        if (row->spans[i][1] > x1) x1 = row->spans[i][1];
+        row->count--;
+        row->spans[i][0] = row->spans[row->count][0];
+        row->spans[i][1] = row->spans[row->count][1];
+    }
+
+    if (row->count == MAX_COVERAGE_SPANS) {
+        row->count = -1;
+        return;
+    }
+
+    row->spans[row->count][0] = (int16_t)x0;
+    row->spans[row->count][1] = (int16_t)x1;
+    row->count++;
+}
+
+// Rasterize the terrain diamonds into per-row spans (same shape as draw_tile)
+static void build_terrain_coverage(void) {
+    const ZoomLevel* level = &g_zoom_levels[g_renderer.zoom];
+    int width = g_renderer.target.width;
+    int height = g_renderer.target.height;
+
+    for (int y = 0; y < height; y++) {
+        g_coverage[y].count = 0;
+    }
+
+    for (int i = 0; i < g_num_visible_tiles; i++) {
+        int screen_x = g_visible_tiles[i].screen_x;
+        int screen_y = g_visible_tiles[i].screen_y;
+
+        if (screen_y >= height || screen_y + level->tile_height <= 0) continue;
+        if (screen_x >= width || screen_x + level->tile_width <= 0) continue;
+
+        for (int row = 0; row < level->tile_height; row++) {
+            int py = screen_y + row;
+            if (py < 0 || py >= height) continue;
+
+            int x0 = screen_x + level->row_offset[row];
+            int x1 = x0 + level->row_width[row];
+            if (x0 < 0) x0 = 0;
+            if (x1 > width) x1 = width;
+            if (x0 >= x1) continue;
+
+            coverage_add_span(&g_coverage[py], x0, x1);
+        }
+    }
+}
+
+// Fill the sky gradient into the gaps the terrain leaves
+static void draw_sky(void) {
+    const uint32_t* sky_rows = get_sky_rows(g_renderer.target.height);
+    if (!sky_rows) return;
+
+    int width = g_renderer.target.width;
+
+    for (int y = 0; y < g_renderer.target.height; y++) {
+        uint8_t* line = render_target_pixel(&g_renderer.target, 0, y);
+        CoverageRow* row = &g_coverage[y];
+
+        if (row->count <= 0) {
+            fill_span_asm(line, width, sky_rows[y]);
+            continue;
+        }
+
+        // Sort spans left to right (at most MAX_COVERAGE_SPANS)
+        for (int i = 1; i < row->count; i++) {
+            int16_t x0 = row->spans[i][0];
+            int16_t x1 = row->spans[i][1];
+            int j = i - 1;
+            while (j >= 0 && row->spans[j][0] > x0) {
+                row->spans[j + 1][0] = row->spans[j][0];
+                row->spans[j + 1][1] = row->spans[j][1];
+                j--;
+            }
+            row->spans[j + 1][0] = x0;
+            row->spans[j + 1][1] = x1;
+        }
+
+        int x = 0;
+        for (int i = 0; i < row->count; i++) {
+            if (row->spans[i][0] > x) {
+                fill_span_asm(line + x * 4, row->spans[i][0] - x, sky_rows[y]);
+            }
+            x = row->spans[i][1];
+        }
+        if (x < width) {
+            fill_span_asm(line + x * 4, width - x, sky_rows[y]);
+        }
+    }
+}
+
 void render_frame(void) {
-    if (!g_renderer.framebuffer) {
+    if (!g_renderer.target.pixels) {
         printf("ERROR: framebuffer is NULL in render_frame!\n");
         return;
     }
     
+    PROFILE_BEGIN(PROF_RENDER_TOTAL);
+    
+    // Pick up the newest simulation snapshot; nothing below touches live sim state
+    const SimSnapshot* snap = acquire_snapshot();
+    
     // Update lighting for current time
-    float time_of_day = get_time_of_day();
-    update_lighting(time_of_day);
+    update_lighting(snap->time_of_day);
+    refresh_color_cache(snap);
     
-    // Draw sky gradient first
-    for (int y = 0; y < g_renderer.screen_height; y++) {
-        uint32_t sky_color = get_sky_color(y, g_renderer.screen_height);
-        for (int x = 0; x < g_renderer.screen_width; x++) {
-            int idx = (y * g_renderer.screen_width + x) * 4;
-            g_renderer.framebuffer[idx + 0] = (sky_color >> 0) & 0xFF;  // B
-            g_renderer.framebuffer[idx + 1] = (sky_color >> 8) & 0xFF;  // G
-            g_renderer.framebuffer[idx + 2] = (sky_color >> 16) & 0xFF; // R
-            g_renderer.framebuffer[idx + 3] = 0xFF;                      // A
-        }
-    }
+    // Draw sky gradient only where the terrain leaves gaps
+    PROFILE_BEGIN(PROF_RENDER_SKY);
+    collect_visible_tiles();
+    build_terrain_coverage();
+    draw_sky();
+    PROFILE_END(PROF_RENDER_SKY);
     
     // Render tiles in proper isometric order (back to front)
-    for (int map_y = 0; map_y < MAP_SIZE; map_y++) {
-        for (int map_x = 0; map_x < MAP_SIZE; map_x++) {
-            int screen_x, screen_y;
-            iso_to_screen(map_x, map_y, &screen_x, &screen_y);
-
-            // Adjust for tile height
-            screen_y -= g_map[map_y][map_x].height * 8;
-
-            // Choose color based on tile type
-            uint32_t color;
-            switch (g_map[map_y][map_x].type) {
-                case 0: color = 0x228B22; break; // Grass (green)
-                case 1: color = 0x808080; break; // Path (gray)
-                case 2: color = 0xFF6347; break; // Ride (tomato)
-                default: color = 0x228B22; break;
-            }
-
-            // Darken based on height for depth effect
-            int brightness = 255 - (g_map[map_y][map_x].height * 20);
-            if (brightness < 100) brightness = 100;
-            
-            uint8_t r = ((color >> 16) & 0xFF) * brightness / 255;
-            uint8_t g = ((color >> 8) & 0xFF) * brightness / 255;
-            uint8_t b = ((color >> 0) & 0xFF) * brightness / 255;
-            color = (r << 16) | (g << 8) | b;
-            
-            // Apply lighting
-            color = apply_lighting(color, 0.0f);
-            
-            // Apply weather tint
-            color = apply_weather_tint(color);
+    PROFILE_BEGIN(PROF_RENDER_TERRAIN);
+    for (int i = 0; i < g_num_visible_tiles; i++) {
+        int screen_x = g_visible_tiles[i].screen_x;
+        int screen_y = g_visible_tiles[i].screen_y;
 
-            // Use assembly optimized tile drawing
-            draw_iso_tile_asm(g_renderer.framebuffer, screen_x, screen_y, 
-                            color, g_renderer.screen_width);
+        // Choose color based on tile type
+        uint32_t color;
+        switch (g_visible_tiles[i].type) {
+            case 0: color = 0x228B22; break; // Grass (green)
+            case 1: color = 0x808080; break; // Path (gray)
+            case 2: color = 0xFF6347; break; // Ride (tomato)
+            default: color = 0x228B22; break;
         }
+
+        // Height shading, lighting and weather tint
+        int shade = g_visible_tiles[i].height;
+        if (shade > MAX_SHADE_LEVEL) shade = MAX_SHADE_LEVEL;
+        color = shade_color(color, shade, COLOR_WEATHER);
+
+        draw_tile(screen_x, screen_y, color);
     }
+    PROFILE_END(PROF_RENDER_TERRAIN);
     
     // Render rides
-    int num_rides = get_num_rides();
-    for (int i = 0; i < num_rides; i++) {
-        int rx, ry, rw, rh, rs;
-        get_ride_info(i, &rx, &ry, &rw, &rh, &rs);
+    PROFILE_BEGIN(PROF_RENDER_OBJECTS);
+    for (int i = 0; i < snap->num_rides; i++) {
+        const SnapshotRide* ride = &snap->rides[i];
+        if (!ride->active) continue;
         
         // Draw ride footprint
-        for (int dy = 0; dy < rh; dy++) {
-            for (int dx = 0; dx < rw; dx++) {
+        for (int dy = 0; dy < ride->height; dy++) {
+            for (int dx = 0; dx < ride->width; dx++) {
                 int screen_x, screen_y;
-                iso_to_screen(rx + dx, ry + dy, &screen_x, &screen_y);
-                
-                uint32_t ride_color = (rs == 3) ? 0x800000 : 0xFF6347;
+                iso_to_screen(ride->x + dx, ride->y + dy, &screen_x, &screen_y);
                 
-                // Apply lighting
-                ride_color = apply_lighting(ride_color, 0.0f);
+                // Ride lights at night come from the light map
+                uint32_t ride_color = shade_color((ride->status == 3) ? 0x800000 : 0xFF6347, 0, COLOR_WEATHER);
                 
-                // Apply weather tint
-                ride_color = apply_weather_tint(ride_color);
-                
-                // Add ride lights at night
-                if (are_lamps_on() && rs != 3) {
-                    uint32_t light_color = get_ride_lights(i);
-                    // Mix ride color with light color
-                    uint8_t r = ((ride_color >> 16) & 0xFF) * 0.6f + ((light_color >> 16) & 0xFF) * 0.4f;
-                    uint8_t g = ((ride_color >> 8) & 0xFF) * 0.6f + ((light_color >> 8) & 0xFF) * 0.4f;
-                    uint8_t b = ((ride_color >> 0) & 0xFF) * 0.6f + ((light_color >> 0) & 0xFF) * 0.4f;
-                    ride_color = (r << 16) | (g << 8) | b;
-                }
-                
-                draw_iso_tile_asm(g_renderer.framebuffer, screen_x, screen_y, 
-                                ride_color, g_renderer.screen_width);
+                draw_tile(screen_x, screen_y, ride_color);
             }
         }
     }
     
     // Render shops
-    int num_shops = get_num_shops();
-    for (int i = 0; i < num_shops; i++) {
-        int sx, sy, st;
-        get_shop_info(i, &sx, &sy, &st);
+    for (int i = 0; i < snap->num_shops; i++) {
+        const SnapshotShop* shop = &snap->shops[i];
         
         int screen_x, screen_y;
-        iso_to_screen(sx, sy, &screen_x, &screen_y);
+        iso_to_screen(shop->x, shop->y, &screen_x, &screen_y);
         
         // Color based on shop type
         uint32_t shop_color;
-        switch (st) {
+        switch (shop->type) {
             case 0: shop_color = 0xFF8C00; break;  // Food - orange
             case 1: shop_color = 0x1E90FF; break;  // Drink - blue
             case 2: shop_color = 0xFFFFFF; break;  // Bathroom - white
@@ -258,127 +561,97 @@ void render_frame(void) {
         }
         
         // Apply lighting
-        shop_color = apply_lighting(shop_color, 0.0f);
+        shop_color = shade_color(shop_color, 0, 0);
         
-        draw_iso_tile_asm(g_renderer.framebuffer, screen_x, screen_y, 
-                        shop_color, g_renderer.screen_width);
+        draw_tile(screen_x, screen_y, shop_color);
     }
     
     // Render scenery
-    int num_scenery = get_num_scenery();
-    for (int i = 0; i < num_scenery; i++) {
-        int scx, scy, sct;
-        uint32_t sc_color;
-        get_scenery_info(i, &scx, &scy, &sct, &sc_color);
+    for (int i = 0; i < snap->num_scenery; i++) {
+        int sct = snap->scenery[i].type;
+        uint32_t sc_color = snap->scenery[i].color;
         
         int screen_x, screen_y;
-        iso_to_screen(scx, scy, &screen_x, &screen_y);
+        iso_to_screen(snap->scenery[i].x, snap->scenery[i].y, &screen_x, &screen_y);
         
         // Draw scenery based on type
         if (sct == 0 || sct == 1) {  // Trees
             // Draw tree trunk
-            uint32_t trunk_color = apply_lighting(0x8B4513, 0.0f);
-            fill_rect_asm(g_renderer.framebuffer, screen_x - 2, screen_y - 6, 
-                         4, 10, trunk_color, g_renderer.screen_width);
+            uint32_t trunk_color = shade_color(0x8B4513, 0, 0);
+            draw_zoomed_rect(screen_x, screen_y, -2, -6, 4, 10, trunk_color);
             // Draw tree canopy
-            uint32_t canopy_color = apply_lighting(sc_color, 0.0f);
-            fill_rect_asm(g_renderer.framebuffer, screen_x - 6, screen_y - 16, 
-                         12, 12, canopy_color, g_renderer.screen_width);
+            uint32_t canopy_color = shade_color(sc_color, 0, 0);
+            draw_zoomed_rect(screen_x, screen_y, -6, -16, 12, 12, canopy_color);
         } else if (sct == 2) {  // Bench
-            uint32_t bench_color = apply_lighting(sc_color, 0.0f);
-            fill_rect_asm(g_renderer.framebuffer, screen_x - 4, screen_y - 4, 
-                         8, 4, bench_color, g_renderer.screen_width);
+            uint32_t bench_color = shade_color(sc_color, 0, 0);
+            draw_zoomed_rect(screen_x, screen_y, -4, -4, 8, 4, bench_color);
         } else if (sct == 3) {  // Lamp
-            uint32_t pole_color = apply_lighting(0x808080, 0.0f);
-            fill_rect_asm(g_renderer.framebuffer, screen_x - 1, screen_y - 12, 
-                         2, 12, pole_color, g_renderer.screen_width);
+            uint32_t pole_color = shade_color(0x808080, 0, 0);
+            draw_zoomed_rect(screen_x, screen_y, -1, -12, 2, 12, pole_color);
             
             // Lamp glows at night
-            uint32_t lamp_color = are_lamps_on() ? get_lamp_glow_color() : apply_lighting(sc_color, 0.0f);
-            fill_rect_asm(g_renderer.framebuffer, screen_x - 3, screen_y - 14, 
-                         6, 4, lamp_color, g_renderer.screen_width);
-            
-            // Add glow effect at night
-            if (are_lamps_on()) {
-                uint32_t glow = 0xFFFFAA;
-                fill_rect_asm(g_renderer.framebuffer, screen_x - 5, screen_y - 16, 
-                             10, 8, glow, g_renderer.screen_width);
-            }
+            uint32_t lamp_color = are_lamps_on() ? get_lamp_glow_color() : shade_color(sc_color, 0, 0);
+            draw_zoomed_rect(screen_x, screen_y, -3, -14, 6, 4, lamp_color);
         } else {  // Other scenery
-            uint32_t scenery_color = apply_lighting(sc_color, 0.0f);
-            fill_rect_asm(g_renderer.framebuffer, screen_x - 3, screen_y - 6, 
-                         6, 6, scenery_color, g_renderer.screen_width);
+            uint32_t scenery_color = shade_color(sc_color, 0, 0);
+            draw_zoomed_rect(screen_x, screen_y, -3, -6, 6, 6, scenery_color);
         }
     }
+    PROFILE_END(PROF_RENDER_OBJECTS);
     
     // Render litter
-    int num_litter = get_num_litter();
-    for (int i = 0; i < num_litter; i++) {
-        float litter_x, litter_y;
-        get_litter_position(i, &litter_x, &litter_y);
-        
+    PROFILE_BEGIN(PROF_RENDER_ENTITIES);
+    for (int i = 0; i < snap->num_litter; i++) {
         int screen_x, screen_y;
-        iso_to_screen((int)litter_x, (int)litter_y, &screen_x, &screen_y);
+        iso_to_screen((int)snap->litter[i].x, (int)snap->litter[i].y, &screen_x, &screen_y);
         
         // Draw small red square for litter
-        fill_rect_asm(g_renderer.framebuffer, screen_x - 2, screen_y - 2, 
-                     4, 4, 0xFF0000, g_renderer.screen_width);
+        draw_zoomed_rect(screen_x, screen_y, -2, -2, 4, 4, 0xFF0000);
     }
     
-    // Render guests on top of tiles
-    int num_guests = get_num_guests();
-    for (int i = 0; i < num_guests; i++) {
-        float guest_x, guest_y;
-        get_guest_position(i, &guest_x, &guest_y);
-        
-        int screen_x, screen_y;
-        iso_to_screen((int)guest_x, (int)guest_y, &screen_x, &screen_y);
+    // Render guests and staff standing in visible chunks
+    for (int i = 0; i < snap->num_guests; i++) {
+        const SnapshotGuest* guest = &snap->guests[i];
+        if (!is_entity_visible(guest->x, guest->y)) continue;
         
         // Adjust for tile height at guest position
-        int tile_x = (int)guest_x;
-        int tile_y = (int)guest_y;
-        if (tile_x >= 0 && tile_x < MAP_SIZE && tile_y >= 0 && tile_y < MAP_SIZE) {
-            screen_y -= g_map[tile_y][tile_x].height * 8;
-        }
-        
-        // Draw guest with their unique color
-        uint32_t guest_color = get_guest_color(i);
+        int screen_x, screen_y;
+        tile_screen_pos((int)guest->x, (int)guest->y, &screen_x, &screen_y);
         
-        // Draw a simple "person" shape (head + body)
-        fill_rect_asm(g_renderer.framebuffer, screen_x - 3, screen_y - 10, 
-                     6, 4, guest_color, g_renderer.screen_width); // Head
-        fill_rect_asm(g_renderer.framebuffer, screen_x - 4, screen_y - 6, 
-                     8, 6, guest_color, g_renderer.screen_width); // Body
+        // Draw a simple "person" shape (head + body) in the guest's color
+        draw_zoomed_rect(screen_x, screen_y, -3, -10, 6, 4, guest->color); // Head
+        draw_zoomed_rect(screen_x, screen_y, -4, -6, 8, 6, guest->color); // Body
     }
     
-    // Render staff
-    int num_staff = get_num_staff();
-    for (int i = 0; i < num_staff; i++) {
-        float staff_x, staff_y;
-        get_staff_position(i, &staff_x, &staff_y);
+    for (int i = 0; i < snap->num_staff; i++) {
+        const SnapshotStaff* staff = &snap->staff[i];
+        if (!is_entity_visible(staff->x, staff->y)) continue;
         
         int screen_x, screen_y;
-        iso_to_screen((int)staff_x, (int)staff_y, &screen_x, &screen_y);
-        
-        int tile_x = (int)staff_x;
-        int tile_y = (int)staff_y;
-        if (tile_x >= 0 && tile_x < MAP_SIZE && tile_y >= 0 && tile_y < MAP_SIZE) {
-            screen_y -= g_map[tile_y][tile_x].height * 8;
-        }
+        tile_screen_pos((int)staff->x, (int)staff->y, &screen_x, &screen_y);
         
         // Staff color based on type (0=janitor, 1=mechanic)
-        int staff_type = get_staff_type(i);
-        uint32_t staff_color = (staff_type == 0) ? 0x00FF00 : 0x0000FF;
+        uint32_t staff_color = (staff->type == 0) ? 0x00FF00 : 0x0000FF;
         
         // Draw staff with uniform
-        fill_rect_asm(g_renderer.framebuffer, screen_x - 3, screen_y - 10, 
-                     6, 4, 0xFFDDCC, g_renderer.screen_width); // Head
-        fill_rect_asm(g_renderer.framebuffer, screen_x - 4, screen_y - 6, 
-                     8, 6, staff_color, g_renderer.screen_width); // Uniform
+        draw_zoomed_rect(screen_x, screen_y, -3, -10, 6, 4, 0xFFDDCC); // Head
+        draw_zoomed_rect(screen_x, screen_y, -4, -6, 8, 6, staff_color); // Uniform
     }
+    PROFILE_END(PROF_RENDER_ENTITIES);
+    
+    // Lamps and ride lights brighten the scene at night
+    PROFILE_BEGIN(PROF_RENDER_LIGHTS);
+    update_light_map(snap, g_renderer.camera_x, g_renderer.camera_y,
+                     g_renderer.target.width, g_renderer.target.height);
+    apply_light_map(&g_renderer.target);
+    PROFILE_END(PROF_RENDER_LIGHTS);
     
     // Render weather particles on top
-    render_weather_particles(g_renderer.framebuffer, g_renderer.screen_width, g_renderer.screen_height);
+    PROFILE_BEGIN(PROF_RENDER_WEATHER);
+    render_weather_particles(snap, &g_renderer.target);
+    PROFILE_END(PROF_RENDER_WEATHER);
+    
+    PROFILE_END(PROF_RENDER_TOTAL);
 }
 
 // Camera control
@@ -387,24 +660,29 @@ void move_camera(int dx, int dy) {
     g_renderer.camera_y += dy;
 }
 
-// Modify terrain
-void set_tile_height(int x, int y, int height) {
-    if (x >= 0 && x < MAP_SIZE && y >= 0 && y < MAP_SIZE) {
-        g_map[y][x].height = height;
-    }
-}
+// Zoom control: keeps the world point at the screen center fixed
+void set_zoom_level(int zoom) {
+    if (zoom < 0) zoom = 0;
+    if (zoom >= NUM_ZOOM_LEVELS) zoom = NUM_ZOOM_LEVELS - 1;
+    if (zoom == g_renderer.zoom) return;
+
+    // World-space projection of the screen center, relative to the map origin
+    int center_x = g_renderer.camera_x;
+    int center_y = g_renderer.camera_y + g_renderer.target.height / 2 - 100;
 
-void set_tile_type(int x, int y, int type) {
-    if (x >= 0 && x < MAP_SIZE && y >= 0 && y < MAP_SIZE) {
-        g_map[y][x].type = type;
+    if (zoom > g_renderer.zoom) {
+        center_x /= 1 << (zoom - g_renderer.zoom);
+        center_y /= 1 << (zoom - g_renderer.zoom);
+    } else {
+        center_x *= 1 << (g_renderer.zoom - zoom);
+        center_y *= 1 << (g_renderer.zoom - zoom);
     }
-}
 
-// Save/Load map data
-void save_map_data(FILE* f) {
-    fwrite(g_map, sizeof(Tile), MAP_SIZE * MAP_SIZE, f);
+    g_renderer.camera_x = center_x;
+    g_renderer.camera_y = center_y - g_renderer.target.height / 2 + 100;
+    g_renderer.zoom = zoom;
 }
 
-void load_map_data(FILE* f) {
-    fread(g_map, sizeof(Tile), MAP_SIZE * MAP_SIZE, f);
-}
\ No newline at end of file
+int get_zoom_level(void) {
+    return g_renderer.zoom;
+}
@@ -0,0 +1,224 @@
+; Span kernels shared by the sky, lighting, text and weather passes
+; Optimized for x86-64 (SSE2)
+
+section .text
+    global fill_span_asm
+
+; Fill a run of 32-bit pixels with a single color
+; void fill_span_asm(uint8_t* dest, int count, uint32_t color)
+; Arguments: rdi=dest, esi=count, edx=color (ARGB)
+fill_span_asm:
+    test esi, esi
+    jle .done
+
+    ; Broadcast color into all four lanes
+    movd xmm0, edx
+    pshufd xmm0, xmm0, 0
+    mov eax, edx
+
+    ; Single stores until dest is 16-byte aligned
+.align_loop:
+    test rdi, 15
+    jz .aligned
+    mov dword [rdi], eax
+    add rdi, 4
+    dec esi
+    jz .done
+    jmp .align_loop
+
+.aligned:
+    ; 16 pixels (64 bytes) per iteration
+    mov ecx, esi
+    shr ecx, 4
+    jz .tail4
+
+.loop16:
+    movdqa [rdi], xmm0
+    movdqa [rdi+16], xmm0
+    movdqa [rdi+32], xmm0
+    movdqa [rdi+48], xmm0
+    add rdi, 64
+    dec ecx
+    jnz .loop16
+
+.tail4:
+    ; Remaining groups of 4 pixels
+    mov ecx, esi
+    and ecx, 15
+    shr ecx, 2
+    jz .tail1
+
+.loop4:
+    movdqa [rdi], xmm0
+    add rdi, 16
+    dec ecx
+    jnz .loop4
+
+.tail1:
+    ; Last 0-3 pixels
+    mov ecx, esi
+    and ecx, 3
+    rep stosd
+
+.done:
+    ret
+
+
+; Multiply each channel of a run of pixels by a fixed-point gain
+; void modulate_span_asm(uint8_t* dest, int count, uint64_t gains)
+; Arguments: rdi=dest, esi=count, rdx=gains
+; gains holds four 8.8 fixed-point factors (B, G, R, A from low to high word),
+; each at most 0x7FFF. Result per channel is min(255, (value * gain) >> 8).
+    global modulate_span_asm
+modulate_span_asm:
+    test esi, esi
+    jle .done
+
+    movq xmm1, rdx
+    punpcklqdq xmm1, xmm1   ; gains for two pixels
+    pxor xmm7, xmm7
+
+    ; 4 pixels per iteration
+    mov ecx, esi
+    shr ecx, 2
+    jz .tail
+
+.loop4:
+    movdqu xmm0, [rdi]
+    movdqa xmm2, xmm0
+    punpcklbw xmm0, xmm7    ; pixels 0-1 as words
+    punpckhbw xmm2, xmm7    ; pixels 2-3 as words
+    psllw xmm0, 8           ; value * 256
+    psllw xmm2, 8
+    pmulhuw xmm0, xmm1      ; (value * 256 * gain) >> 16
+    pmulhuw xmm2, xmm1
+    packuswb xmm0, xmm2     ; saturate back to bytes
+    movdqu [rdi], xmm0
+    add rdi, 16
+    dec ecx
+    jnz .loop4
+
+.tail:
+    and esi, 3
+    jz .done
+
+.loop1:
+    movd xmm0, [rdi]
+    punpcklbw xmm0, xmm7
+    psllw xmm0, 8
+    pmulhuw xmm0, xmm1
+    packuswb xmm0, xmm0
+    movd [rdi], xmm0
+    add rdi, 4
+    dec esi
+    jnz .loop1
+
+.done:
+    ret
+
+
+; Shared setup for the blend kernels
+; Input: edx=color (RGB), ecx=alpha (0-255)
+; Output: xmm1=color * a as words (two pixels), xmm3=256 - a as words, xmm7=0
+; a is alpha rescaled to 0-256 so that 255 replaces the pixel outright.
+; Clobbers eax, ecx, edx, xmm2.
+blend_setup:
+    mov eax, ecx
+    shr eax, 7
+    add ecx, eax            ; a = alpha + (alpha >> 7)
+
+    movd xmm2, ecx
+    pshuflw xmm2, xmm2, 0
+    punpcklqdq xmm2, xmm2   ; a in all eight words
+
+    mov eax, 256
+    sub eax, ecx
+    movd xmm3, eax
+    pshuflw xmm3, xmm3, 0
+    punpcklqdq xmm3, xmm3   ; 256 - a in all eight words
+
+    or edx, 0xFF000000      ; Blended pixels stay opaque
+    movd xmm1, edx
+    pshufd xmm1, xmm1, 0
+    pxor xmm7, xmm7
+    punpcklbw xmm1, xmm7
+    pmullw xmm1, xmm2       ; color * a (at most 255 * 256, fits a word)
+    ret
+
+
+; Blend a horizontal run of pixels toward a color
+; void blend_span_asm(uint8_t* dest, int count, uint32_t color, int alpha)
+; Arguments: rdi=dest, esi=count, edx=color (RGB), ecx=alpha (0-255)
+; Per channel: dest = (color * a + dest * (256 - a)) >> 8
+    global blend_span_asm
+blend_span_asm:
+    test esi, esi
+    jle .done
+    call blend_setup
+
+    ; 4 pixels per iteration
+    mov ecx, esi
+    shr ecx, 2
+    jz .tail
+
+.loop4:
+    movdqu xmm0, [rdi]
+    movdqa xmm4, xmm0
+    punpcklbw xmm0, xmm7
+    punpckhbw xmm4, xmm7
+    pmullw xmm0, xmm3
+    pmullw xmm4, xmm3
+    paddw xmm0, xmm1
+    paddw xmm4, xmm1
+    psrlw xmm0, 8
+    psrlw xmm4, 8
+    packuswb xmm0, xmm4
+    movdqu [rdi], xmm0
+    add rdi, 16
+    dec ecx
+    jnz .loop4
+
+.tail:
+    and esi, 3
+    jz .done
+
+.loop1:
+    movd xmm0, [rdi]
+    punpcklbw xmm0, xmm7
+    pmullw xmm0, xmm3
+    paddw xmm0, xmm1
+    psrlw xmm0, 8
+    packuswb xmm0, xmm0
+    movd [rdi], xmm0
+    add rdi, 4
+    dec esi
+    jnz .loop1
+
+.done:
+    ret
+
+
+; Blend a vertical run of pixels toward a color
+; void blend_column_asm(uint8_t* dest, int count, uint32_t color, int alpha, int pitch)
+; Arguments: rdi=dest, esi=count, edx=color (RGB), ecx=alpha (0-255), r8d=pitch (bytes)
+    global blend_column_asm
+blend_column_asm:
+    test esi, esi
+    jle .done
+    call blend_setup
+    movsxd r8, r8d
+
+.loop1:
+    movd xmm0, [rdi]
+    punpcklbw xmm0, xmm7
+    pmullw xmm0, xmm3
+    paddw xmm0, xmm1
+    psrlw xmm0, 8
+    packuswb xmm0, xmm0
+    movd [rdi], xmm0
+    add rdi, r8
+    dec esi
+    jnz .loop1
+
+.done:
+    ret
@@ -1,6 +1,12 @@
 ; Sprite blitting routines with transparency
 ; Optimized for x86-64
 
+; RenderTarget field offsets (must match src/core/render_target.h)
+RT_PIXELS equ 0
+RT_WIDTH equ 8
+RT_HEIGHT equ 12
+RT_PITCH equ 16
+
 section .text
     global blit_sprite_asm
 
@@ -66,187 +72,84 @@ blit_sprite_asm:
     ret
 
 
-; Fast horizontal line drawing
-; void draw_hline_asm(uint8_t* dest, int x, int y, int width, uint32_t color, int screen_width)
+; Fast horizontal line drawing (clipped to the target)
+; void draw_hline_asm(const RenderTarget* target, int x, int y, int width, uint32_t color)
+; Arguments: rdi=target, esi=x, edx=y, ecx=width, r8d=color
     global draw_hline_asm
 draw_hline_asm:
-    ; rdi=dest, esi=x, edx=y, ecx=width, r8d=color, r9d=screen_width
-    push rbp
-    mov rbp, rsp
-
-    ; Calculate offset: (y * screen_width + x) * 4
-    mov eax, edx
-    imul eax, r9d       ; y * screen_width
-    add eax, esi        ; + x
-    shl eax, 2          ; * 4
-    add rdi, rax        ; dest += offset
-
-    ; Prepare color in eax
-    mov eax, r8d
-
-    ; Draw pixels
-.loop:
-    test ecx, ecx
-    jz .done
-    stosd               ; Write color, advance rdi
-    dec ecx
-    jmp .loop
-
-.done:
-    pop rbp
-    ret
+    mov r9d, r8d        ; color
+    mov r8d, 1          ; height
+    jmp fill_rect_asm
 
 
-; Fast vertical line drawing
-; void draw_vline_asm(uint8_t* dest, int x, int y, int height, uint32_t color, int screen_width)
-global draw_vline_asm
+; Fast vertical line drawing (clipped to the target)
+; void draw_vline_asm(const RenderTarget* target, int x, int y, int height, uint32_t color)
+; Arguments: rdi=target, esi=x, edx=y, ecx=height, r8d=color
+    global draw_vline_asm
 draw_vline_asm:
-; rdi=dest, esi=x, edx=y, ecx=height, r8d=color, r9d=screen_width
-push rbp
-mov rbp, rsp
-
-; Calculate initial offset
-mov eax, edx
-imul eax, r9d
-add eax, esi
-shl eax, 2
-add rdi, rax
-
-; Calculate row stride
-shl r9d, 2          ; screen_width * 4
-
-mov eax, r8d        ; color
-
-.loop:
-test ecx, ecx
-jz .done
-mov dword [rdi], eax
-add rdi, r9         ; Move to next row
-dec ecx
-jmp .loop
-
-.done:
-pop rbp
-ret
+    mov r9d, r8d        ; color
+    mov r8d, ecx        ; height
+    mov ecx, 1          ; width
+    jmp fill_rect_asm
 
 
-; Fill rectangle with bounds checking
-; void fill_rect_asm(uint8_t* dest, int x, int y, int width, int height, uint32_t color, int screen_width)
-global fill_rect_asm
+; Fill rectangle, clipped to the target
+; void fill_rect_asm(const RenderTarget* target, int x, int y, int width, int height, uint32_t color)
+; Arguments: rdi=target, esi=x, edx=y, ecx=width, r8d=height, r9d=color
+    global fill_rect_asm
 fill_rect_asm:
-    push rbp
-    mov rbp, rsp
-    push rbx
-    push r12
-    push r13
-    push r14
-    push r15
-
-    ; Get screen_width from stack
-    mov r12d, dword [rbp+16]
-
-    ; Validate inputs
     test rdi, rdi
-    jz .done                  ; NULL check
+    jz .done                  ; NULL target
+    mov r10, [rdi + RT_PIXELS]
+    test r10, r10
+    jz .done                  ; NULL pixels
 
-    test ecx, ecx
-    jle .done                 ; width <= 0
-
-    test r8d, r8d
-    jle .done                 ; height <= 0
-
-    ; Clip x to screen bounds
+    ; Clip [x, x + width) to [0, target width)
+    lea eax, [rsi + rcx]      ; x1
     test esi, esi
-    jns .x_ok
-    xor esi, esi              ; x = 0 if negative
-.x_ok:
-    cmp esi, r12d
-    jl .x_in_bounds
-    jmp .done                 ; x >= screen_width, nothing to draw
-.x_in_bounds:
-
-    ; Clip y to screen bounds
+    jns .x0_ok
+    xor esi, esi
+.x0_ok:
+    cmp eax, [rdi + RT_WIDTH]
+    jle .x1_ok
+    mov eax, [rdi + RT_WIDTH]
+.x1_ok:
+    sub eax, esi
+    jle .done                 ; Nothing left to draw
+    mov ecx, eax              ; clipped width
+
+    ; Clip [y, y + height) to [0, target height)
+    lea eax, [rdx + r8]       ; y1
     test edx, edx
-    jns .y_ok
-    xor edx, edx              ; y = 0 if negative
-.y_ok:
-    mov r14d, 600             ; SCREEN_HEIGHT
-    cmp edx, r14d
-    jl .y_in_bounds
-    jmp .done                 ; y >= screen_height
-.y_in_bounds:
-
-    ; Clip width to fit screen
-    mov r13d, ecx             ; requested width
-    mov eax, esi
-    add eax, ecx              ; x + width
-    cmp eax, r12d
-    jle .width_ok
-    ; Width extends past screen, clip it
-    mov r13d, r12d
-    sub r13d, esi             ; width = screen_width - x
-.width_ok:
-
-    ; Clip height to fit screen
-    mov r15d, r8d             ; requested height
-    mov eax, edx
-    add eax, r8d              ; y + height
-    cmp eax, r14d
-    jle .height_ok
-    ; Height extends past screen, clip it
-    mov r15d, r14d
-    sub r15d, edx             ; height = screen_height - y
-.height_ok:
-
-    ; Final validation
-    test r13d, r13d
-    jle .done
-    test r15d, r15d
+    jns .y0_ok
+    xor edx, edx
+.y0_ok:
+    cmp eax, [rdi + RT_HEIGHT]
+    jle .y1_ok
+    mov eax, [rdi + RT_HEIGHT]
+.y1_ok:
+    sub eax, edx
     jle .done
+    mov r8d, eax              ; clipped height
 
-    ; Calculate starting address: dest + (y * screen_width + x) * 4
-    mov eax, edx              ; y
-    imul eax, r12d            ; y * screen_width
-    add eax, esi              ; + x
-    movsxd rax, eax
-    shl rax, 2                ; * 4
-    add rdi, rax
-
-    ; Calculate bytes per row: screen_width * 4
-    mov r8d, r12d
-    shl r8d, 2
-
-    ; Calculate bytes to advance after each row
-    mov ebx, r13d
-    shl ebx, 2                ; width * 4
-    mov r14d, r8d
-    sub r14d, ebx             ; row_advance = (screen_width - width) * 4
+    ; Starting address: pixels + y * pitch + x * 4
+    movsxd r11, dword [rdi + RT_PITCH]
+    movsxd rax, edx
+    imul rax, r11
+    add r10, rax
+    movsxd rax, esi
+    lea r10, [r10 + rax*4]
 
-.row_loop:
-    test r15d, r15d
-    jz .done
-
-    ; Fill one row
-    mov ecx, r13d             ; width
     mov eax, r9d              ; color
+    mov r9d, ecx              ; width
 
-.pixel_loop:
-    test ecx, ecx
-    jz .next_row
-    stosd
-    dec ecx
-    jmp .pixel_loop
-
-.next_row:
-    add rdi, r14              ; advance to next row
-    dec r15d
-    jmp .row_loop
+.row_loop:
+    mov rdi, r10
+    mov ecx, r9d
+    rep stosd
+    add r10, r11              ; next row
+    dec r8d
+    jnz .row_loop
 
 .done:
-    pop r15
-    pop r14
-    pop r13
-    pop r12
-    pop rbx
-    pop rbp
     ret
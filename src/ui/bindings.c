@@ -0,0 +1,30 @@
+#include <string.h>
+
+#include "bindings.h"
+
+bool observe_int(ObservableInt* obs, int value) {
+    if (obs->value == value) return false;
+
+    obs->value = value;
+    obs->generation++;
+    return true;
+}
+
+bool observe_text(ObservableText* obs, const char* value) {
+    if (!value) value = "";
+    if (strncmp(obs->value, value, OBSERVABLE_TEXT_SIZE - 1) == 0) return false;
+
+    strncpy(obs->value, value, OBSERVABLE_TEXT_SIZE - 1);
+    obs->value[OBSERVABLE_TEXT_SIZE - 1] = '\0';
+    obs->generation++;
+    return true;
+}
+
+bool binding_stale(const TextBinding* binding, uint32_t generation) {
+    return !binding->valid || binding->seen_generation != generation;
+}
+
+void commit_binding(TextBinding* binding, uint32_t generation) {
+    binding->seen_generation = generation;
+    binding->valid = true;
+}
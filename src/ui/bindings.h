@@ -0,0 +1,41 @@
+#ifndef BINDINGS_H
+#define BINDINGS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Observable values: each carries a generation counter that is bumped only
+// when the value actually changes, so readers can tell "same as last time"
+// with a single integer compare.
+
+#define OBSERVABLE_TEXT_SIZE 32
+#define BINDING_TEXT_SIZE 64
+
+typedef struct {
+    int value;
+    uint32_t generation;
+} ObservableInt;
+
+typedef struct {
+    char value[OBSERVABLE_TEXT_SIZE];
+    uint32_t generation;
+} ObservableText;
+
+// Store a new value; returns true (and bumps the generation) if it changed
+bool observe_int(ObservableInt* obs, int value);
+bool observe_text(ObservableText* obs, const char* value);
+
+// A formatted string cached against the generations of its sources.
+// Generations only ever grow, so their sum changes whenever any source does.
+typedef struct {
+    uint32_t seen_generation;
+    bool valid;
+    char text[BINDING_TEXT_SIZE];
+} TextBinding;
+
+// True if the binding must be re-formatted for this source generation.
+// The caller formats into binding->text and then calls commit_binding.
+bool binding_stale(const TextBinding* binding, uint32_t generation);
+void commit_binding(TextBinding* binding, uint32_t generation);
+
+#endif // BINDINGS_H
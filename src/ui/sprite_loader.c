@@ -8,6 +8,8 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "../core/render_target.h"
+
 #define MAX_SPRITES 256
 #define SPRITE_CACHE_SIZE 1024 * 1024 * 16  // 16MB sprite cache
 
@@ -54,8 +56,8 @@ bool init_sprite_system(void) {
     return true;
 }
 
-// Load a sprite from PNG file
-int load_sprite(const char* filename) {
+// Load a sprite strip of equal-width frames
+static int load_sprite_frames(const char* filename, int frame_width) {
     if (g_sprite_count >= MAX_SPRITES) {
         printf("Sprite limit reached!\n");
         return -1;
@@ -95,8 +97,8 @@ int load_sprite(const char* filename) {
     sprite->height = height;
     sprite->channels = 4; // Always RGBA
     sprite->loaded = true;
-    sprite->frame_count = 1;
-    sprite->frame_width = width;
+    sprite->frame_width = (frame_width > 0 && frame_width <= width) ? frame_width : width;
+    sprite->frame_count = width / sprite->frame_width;
     strncpy(sprite->name, filename, sizeof(sprite->name) - 1);
     
     stbi_image_free(data);
@@ -110,17 +112,18 @@ int load_sprite(const char* filename) {
     return sprite_id;
 }
 
+// Load a sprite from PNG file
+int load_sprite(const char* filename) {
+    return load_sprite_frames(filename, 0);
+}
+
 // Load a sprite sheet (horizontal frames)
 int load_sprite_sheet(const char* filename, int frame_width) {
-    int sprite_id = load_sprite(filename);
+    int sprite_id = load_sprite_frames(filename, frame_width);
     if (sprite_id < 0) return -1;
     
     Sprite* sprite = &g_sprites[sprite_id];
     
-    // Calculate frame count
-    sprite->frame_count = sprite->width / frame_width;
-    sprite->frame_width = frame_width;
-    
     printf("  Sprite sheet: %d frames of %dx%d\n", 
            sprite->frame_count, frame_width, sprite->height);
     
@@ -141,8 +144,7 @@ bool get_sprite_info(int sprite_id, int* width, int* height, int* frame_count) {
 }
 
 // Draw sprite at position
-void draw_sprite(uint8_t* framebuffer, int screen_width, int screen_height,
-                 int sprite_id, int x, int y, int frame) {
+void draw_sprite(const RenderTarget* target, int sprite_id, int x, int y, int frame) {
     if (sprite_id < 0 || sprite_id >= g_sprite_count || !g_sprites[sprite_id].loaded) {
         return;
     }
@@ -158,22 +160,22 @@ void draw_sprite(uint8_t* framebuffer, int screen_width, int screen_height,
     uint8_t* frame_data = sprite->data + frame_offset;
     
     // Bounds check
-    if (x + sprite->frame_width < 0 || x >= screen_width ||
-        y + sprite->height < 0 || y >= screen_height) {
+    if (x + sprite->frame_width < 0 || x >= target->width ||
+        y + sprite->height < 0 || y >= target->height) {
         return;
     }
     
-    // Draw each row
+    // Draw each row (rows of a sheet span every frame)
     for (int row = 0; row < sprite->height; row++) {
         int screen_y = y + row;
-        if (screen_y < 0 || screen_y >= screen_height) continue;
+        if (screen_y < 0 || screen_y >= target->height) continue;
         
         for (int col = 0; col < sprite->frame_width; col++) {
             int screen_x = x + col;
-            if (screen_x < 0 || screen_x >= screen_width) continue;
+            if (screen_x < 0 || screen_x >= target->width) continue;
             
             // Get pixel from sprite
-            int sprite_idx = (row * sprite->frame_width + col) * 4;
+            int sprite_idx = (row * sprite->width + col) * 4;
             uint8_t r = frame_data[sprite_idx + 0];
             uint8_t g = frame_data[sprite_idx + 1];
             uint8_t b = frame_data[sprite_idx + 2];
@@ -183,18 +185,17 @@ void draw_sprite(uint8_t* framebuffer, int screen_width, int screen_height,
             if (a < 128) continue;
             
             // Write to framebuffer
-            int fb_idx = (screen_y * screen_width + screen_x) * 4;
-            framebuffer[fb_idx + 0] = b;
-            framebuffer[fb_idx + 1] = g;
-            framebuffer[fb_idx + 2] = r;
-            framebuffer[fb_idx + 3] = 255;
+            uint8_t* dest = render_target_pixel(target, screen_x, screen_y);
+            dest[0] = b;
+            dest[1] = g;
+            dest[2] = r;
+            dest[3] = 255;
         }
     }
 }
 
 // Draw sprite with scaling
-void draw_sprite_scaled(uint8_t* framebuffer, int screen_width, int screen_height,
-                        int sprite_id, int x, int y, int frame, float scale) {
+void draw_sprite_scaled(const RenderTarget* target, int sprite_id, int x, int y, int frame, float scale) {
     if (sprite_id < 0 || sprite_id >= g_sprite_count || !g_sprites[sprite_id].loaded) {
         return;
     }
@@ -214,13 +215,13 @@ void draw_sprite_scaled(uint8_t* framebuffer, int screen_width, int screen_heigh
     // Draw with nearest-neighbor scaling
     for (int row = 0; row < scaled_height; row++) {
         int screen_y = y + row;
-        if (screen_y < 0 || screen_y >= screen_height) continue;
+        if (screen_y < 0 || screen_y >= target->height) continue;
         
         int src_row = (int)(row / scale);
         
         for (int col = 0; col < scaled_width; col++) {
             int screen_x = x + col;
-            if (screen_x < 0 || screen_x >= screen_width) continue;
+            if (screen_x < 0 || screen_x >= target->width) continue;
             
             int src_col = (int)(col / scale);
             
@@ -235,18 +236,17 @@ void draw_sprite_scaled(uint8_t* framebuffer, int screen_width, int screen_heigh
             if (a < 128) continue;
             
             // Write to framebuffer
-            int fb_idx = (screen_y * screen_width + screen_x) * 4;
-            framebuffer[fb_idx + 0] = b;
-            framebuffer[fb_idx + 1] = g;
-            framebuffer[fb_idx + 2] = r;
-            framebuffer[fb_idx + 3] = 255;
+            uint8_t* dest = render_target_pixel(target, screen_x, screen_y);
+            dest[0] = b;
+            dest[1] = g;
+            dest[2] = r;
+            dest[3] = 255;
         }
     }
 }
 
 // Draw sprite with tint/color multiplication
-void draw_sprite_tinted(uint8_t* framebuffer, int screen_width, int screen_height,
-                        int sprite_id, int x, int y, int frame, uint32_t tint) {
+void draw_sprite_tinted(const RenderTarget* target, int sprite_id, int x, int y, int frame, uint32_t tint) {
     if (sprite_id < 0 || sprite_id >= g_sprite_count || !g_sprites[sprite_id].loaded) {
         return;
     }
@@ -265,11 +265,11 @@ void draw_sprite_tinted(uint8_t* framebuffer, int screen_width, int screen_heigh
     
     for (int row = 0; row < sprite->height; row++) {
         int screen_y = y + row;
-        if (screen_y < 0 || screen_y >= screen_height) continue;
+        if (screen_y < 0 || screen_y >= target->height) continue;
         
         for (int col = 0; col < sprite->frame_width; col++) {
             int screen_x = x + col;
-            if (screen_x < 0 || screen_x >= screen_width) continue;
+            if (screen_x < 0 || screen_x >= target->width) continue;
             
             int sprite_idx = (row * sprite->frame_width + col) * 4;
             uint8_t r = frame_data[sprite_idx + 0];
@@ -284,11 +284,11 @@ void draw_sprite_tinted(uint8_t* framebuffer, int screen_width, int screen_heigh
             g = (g * tint_g) / 255;
             b = (b * tint_b) / 255;
             
-            int fb_idx = (screen_y * screen_width + screen_x) * 4;
-            framebuffer[fb_idx + 0] = b;
-            framebuffer[fb_idx + 1] = g;
-            framebuffer[fb_idx + 2] = r;
-            framebuffer[fb_idx + 3] = 255;
+            uint8_t* dest = render_target_pixel(target, screen_x, screen_y);
+            dest[0] = b;
+            dest[1] = g;
+            dest[2] = r;
+            dest[3] = 255;
         }
     }
 }
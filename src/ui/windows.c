@@ -5,37 +5,26 @@
 #include <string.h>
 #include <SDL2/SDL.h>
 
+#include "../core/snapshot.h"
+#include "../core/render_target.h"
+#include "bindings.h"
+#include "../core/replay.h"
+
 // External bitmap font functions
-extern void draw_char_bitmap(uint8_t* framebuffer, int x, int y, char c, 
-                             uint32_t color, int screen_width);
-extern void draw_text_bitmap(uint8_t* framebuffer, int x, int y, const char* text, 
-                             uint32_t color, int screen_width);
+extern void draw_char_bitmap(const RenderTarget* target, int x, int y, char c, uint32_t color);
+extern void draw_text_bitmap(const RenderTarget* target, int x, int y, const char* text, uint32_t color);
 
 // External assembly drawing functions
-extern void fill_rect_asm(uint8_t* dest, int x, int y, int width, int height, uint32_t color, int screen_width);
-extern void draw_hline_asm(uint8_t* dest, int x, int y, int width, uint32_t color, int screen_width);
-extern void draw_vline_asm(uint8_t* dest, int x, int y, int height, uint32_t color, int screen_width);
+extern void fill_rect_asm(const RenderTarget* target, int x, int y, int width, int height, uint32_t color);
+extern void draw_hline_asm(const RenderTarget* target, int x, int y, int width, uint32_t color);
+extern void draw_vline_asm(const RenderTarget* target, int x, int y, int height, uint32_t color);
 
-extern void draw_sprite(uint8_t* framebuffer, int x, int y, int sprite_id, int screen_width);
+extern void draw_sprite(const RenderTarget* target, int sprite_id, int x, int y, int frame);
 extern void load_sprite_sheet(const char* filename);
 
-// External getters from simulation
-extern int get_num_guests(void);
-extern int get_park_rating(void);
-extern int get_park_money(void);
-extern int get_total_guests_entered(void);
-extern float get_time_of_day(void);
-
-// External weather functions
-extern const char* get_weather_name(void);
-
-// External ride functions
-extern int get_num_rides(void);
-extern const char* get_ride_name(int idx);
-extern int get_ride_queue(int idx);
-
-// External staff functions
-extern int get_num_staff(void);
+// Simulation access: reads go through the snapshot, writes hold the lock
+extern void lock_simulation(void);
+extern void unlock_simulation(void);
 
 // External terrain functions
 extern void set_tile_height(int x, int y, int height);
@@ -43,8 +32,7 @@ extern void set_tile_type(int x, int y, int type);
 extern void screen_to_iso(int screen_x, int screen_y, int* iso_x, int* iso_y);
 
 #define MAX_WINDOWS 10
-#define SCREEN_WIDTH 800
-#define SCREEN_HEIGHT 600
+#define MAX_RIDE_ROWS 5
 
 typedef enum {
     TOOL_NONE,
@@ -66,80 +54,156 @@ typedef struct {
     int x, y;
     int width, height;
     char title[64];
+    
+    // Retained rendering: redrawn only when a bound value changes
+    RenderTarget surface;
+    uint32_t content_generation;
+    bool surface_valid;
 } Window;
 
 static Window g_windows[MAX_WINDOWS] = {0};
-static uint8_t* g_framebuffer = NULL;
+static RenderTarget g_screen = {0};
 static ToolType g_current_tool = TOOL_NONE;
 
+// Where the window drawing functions currently write to
+static RenderTarget g_target = {0};
+
+// Values the windows display, refreshed from the snapshot once per frame
+typedef struct {
+    ObservableInt clock;            // Minutes since midnight
+    ObservableText weather;
+    ObservableInt guests;
+    ObservableInt total_guests;
+    ObservableInt rating;
+    ObservableInt money;
+    ObservableInt staff;
+    ObservableInt rides;
+    ObservableInt tool;
+    ObservableText ride_names[MAX_RIDE_ROWS];
+    ObservableInt ride_queues[MAX_RIDE_ROWS];
+} UiValues;
+
+static UiValues g_values = {0};
+
+// Formatted text, re-built only when its source generation moves
+static TextBinding g_time_text = {0};
+static TextBinding g_weather_text = {0};
+static TextBinding g_guests_text = {0};
+static TextBinding g_total_text = {0};
+static TextBinding g_rating_text = {0};
+static TextBinding g_money_text = {0};
+static TextBinding g_staff_text = {0};
+static TextBinding g_rides_text = {0};
+static TextBinding g_tool_text = {0};
+static TextBinding g_ride_rows[MAX_RIDE_ROWS] = {0};
+
+static void update_ui_values(void) {
+    const SimSnapshot* snap = get_current_snapshot();
+    
+    int hour = (int)snap->time_of_day;
+    int minute = (int)((snap->time_of_day - hour) * 60);
+    observe_int(&g_values.clock, hour * 60 + minute);
+    observe_text(&g_values.weather, snap->weather_name);
+    observe_int(&g_values.guests, snap->num_guests);
+    observe_int(&g_values.total_guests, snap->total_guests_entered);
+    observe_int(&g_values.rating, snap->park_rating);
+    observe_int(&g_values.money, snap->park_money);
+    observe_int(&g_values.staff, snap->num_staff);
+    observe_int(&g_values.rides, snap->num_rides);
+    observe_int(&g_values.tool, g_current_tool);
+    
+    for (int i = 0; i < snap->num_rides && i < MAX_RIDE_ROWS; i++) {
+        const SnapshotRide* ride = &snap->rides[i];
+        observe_text(&g_values.ride_names[i], ride->active ? ride->name : "Unknown");
+        observe_int(&g_values.ride_queues[i], ride->active ? ride->queue_length : 0);
+    }
+}
+
+static void update_int_binding(TextBinding* binding, const char* format, const ObservableInt* obs) {
+    if (!binding_stale(binding, obs->generation)) return;
+    snprintf(binding->text, sizeof(binding->text), format, obs->value);
+    commit_binding(binding, obs->generation);
+}
+
+static void update_ui_bindings(void) {
+    if (binding_stale(&g_time_text, g_values.clock.generation)) {
+        int hour = g_values.clock.value / 60;
+        int minute = g_values.clock.value % 60;
+        const char* period = (hour >= 12) ? "PM" : "AM";
+        int display_hour = hour % 12;
+        if (display_hour == 0) display_hour = 12;
+        
+        snprintf(g_time_text.text, sizeof(g_time_text.text), "Time: %d:%02d %s", display_hour, minute, period);
+        commit_binding(&g_time_text, g_values.clock.generation);
+    }
+    
+    if (binding_stale(&g_weather_text, g_values.weather.generation)) {
+        snprintf(g_weather_text.text, sizeof(g_weather_text.text), "Weather: %s", g_values.weather.value);
+        commit_binding(&g_weather_text, g_values.weather.generation);
+    }
+    
+    update_int_binding(&g_guests_text, "Guests: %d", &g_values.guests);
+    update_int_binding(&g_total_text, "Total: %d", &g_values.total_guests);
+    update_int_binding(&g_rating_text, "Rating: %d", &g_values.rating);
+    update_int_binding(&g_money_text, "Money: $%d", &g_values.money);
+    update_int_binding(&g_staff_text, "Staff: %d", &g_values.staff);
+    update_int_binding(&g_rides_text, "Rides: %d", &g_values.rides);
+    
+    if (binding_stale(&g_tool_text, g_values.tool.generation)) {
+        const char* tool_names[] = {"None", "Raise", "Lower", "Path", "Demolish"};
+        snprintf(g_tool_text.text, sizeof(g_tool_text.text), "Active: %s", tool_names[g_values.tool.value]);
+        commit_binding(&g_tool_text, g_values.tool.generation);
+    }
+    
+    for (int i = 0; i < g_values.rides.value && i < MAX_RIDE_ROWS; i++) {
+        uint32_t generation = g_values.ride_names[i].generation + g_values.ride_queues[i].generation;
+        if (!binding_stale(&g_ride_rows[i], generation)) continue;
+        
+        snprintf(g_ride_rows[i].text, sizeof(g_ride_rows[i].text), "%s: %d",
+                 g_values.ride_names[i].value, g_values.ride_queues[i].value);
+        commit_binding(&g_ride_rows[i], generation);
+    }
+}
+
 static void draw_window_frame(Window* win) {
     // Window background
-    fill_rect_asm(g_framebuffer, win->x, win->y, win->width, win->height, 
-                  0xC0C0C0, SCREEN_WIDTH);
+    fill_rect_asm(&g_target, win->x, win->y, win->width, win->height, 
+                  0xC0C0C0);
     
     // Title bar
-    fill_rect_asm(g_framebuffer, win->x, win->y, win->width, 20,
-                  0x0000AA, SCREEN_WIDTH);
+    fill_rect_asm(&g_target, win->x, win->y, win->width, 20,
+                  0x0000AA);
     
-    draw_sprite(g_framebuffer, win->x + 2, win->y + 2, 0, SCREEN_WIDTH);
+    draw_sprite(&g_target, 0, win->x + 2, win->y + 2, 0);
                   // Border
-    draw_hline_asm(g_framebuffer, win->x, win->y, win->width, 
-                   0x000000, SCREEN_WIDTH);
-    draw_hline_asm(g_framebuffer, win->x, win->y + win->height - 1, win->width,
-                   0x000000, SCREEN_WIDTH);
-    draw_vline_asm(g_framebuffer, win->x, win->y, win->height,
-                   0x000000, SCREEN_WIDTH);
-    draw_vline_asm(g_framebuffer, win->x + win->width - 1, win->y, win->height,
-                   0x000000, SCREEN_WIDTH);
+    draw_hline_asm(&g_target, win->x, win->y, win->width, 
+                   0x000000);
+    draw_hline_asm(&g_target, win->x, win->y + win->height - 1, win->width,
+                   0x000000);
+    draw_vline_asm(&g_target, win->x, win->y, win->height,
+                   0x000000);
+    draw_vline_asm(&g_target, win->x + win->width - 1, win->y, win->height,
+                   0x000000);
     
     // Title text using bitmap font
-    draw_text_bitmap(g_framebuffer, win->x + 5, win->y + 6, win->title, 0xFFFFFF, SCREEN_WIDTH);
+    draw_text_bitmap(&g_target, win->x + 5, win->y + 6, win->title, 0xFFFFFF);
 }
 
 static void draw_stats_window(Window* win) {
-    char buffer[64];
+    const TextBinding* lines[] = {
+        &g_time_text, &g_weather_text, &g_guests_text, &g_total_text,
+        &g_rating_text, &g_money_text, &g_staff_text, &g_rides_text
+    };
     
     int y = win->y + 30;
-    
-    // Time of day
-    float time = get_time_of_day();
-    int hour = (int)time;
-    int minute = (int)((time - hour) * 60);
-    const char* period = (hour >= 12) ? "PM" : "AM";
-    int display_hour = hour % 12;
-    if (display_hour == 0) display_hour = 12;
-    
-    snprintf(buffer, sizeof(buffer), "Time: %d:%02d %s", display_hour, minute, period);
-    draw_text_bitmap(g_framebuffer, win->x + 10, y, buffer, 0x000080, SCREEN_WIDTH);
-    y += 12;
-    
-    // Weather
-    snprintf(buffer, sizeof(buffer), "Weather: %s", get_weather_name());
-    draw_text_bitmap(g_framebuffer, win->x + 10, y, buffer, 0x006400, SCREEN_WIDTH);
-    y += 12;
-    
-    snprintf(buffer, sizeof(buffer), "Guests: %d", get_num_guests());
-    draw_text_bitmap(g_framebuffer, win->x + 10, y, buffer, 0x000000, SCREEN_WIDTH);
-    y += 12;
-    
-    snprintf(buffer, sizeof(buffer), "Total: %d", get_total_guests_entered());
-    draw_text_bitmap(g_framebuffer, win->x + 10, y, buffer, 0x000000, SCREEN_WIDTH);
-    y += 12;
-    
-    snprintf(buffer, sizeof(buffer), "Rating: %d", get_park_rating());
-    draw_text_bitmap(g_framebuffer, win->x + 10, y, buffer, 0x000000, SCREEN_WIDTH);
-    y += 12;
-    
-    snprintf(buffer, sizeof(buffer), "Money: $%d", get_park_money());
-    draw_text_bitmap(g_framebuffer, win->x + 10, y, buffer, 0x000000, SCREEN_WIDTH);
-    y += 12;
-    
-    snprintf(buffer, sizeof(buffer), "Staff: %d", get_num_staff());
-    draw_text_bitmap(g_framebuffer, win->x + 10, y, buffer, 0x000000, SCREEN_WIDTH);
-    y += 12;
-    
-    snprintf(buffer, sizeof(buffer), "Rides: %d", get_num_rides());
-    draw_text_bitmap(g_framebuffer, win->x + 10, y, buffer, 0x000000, SCREEN_WIDTH);
+    for (int i = 0; i < 8; i++) {
+        uint32_t color = 0x000000;
+        if (i == 0) color = 0x000080;       // Time of day
+        else if (i == 1) color = 0x006400;  // Weather
+        
+        draw_text_bitmap(&g_target, win->x + 10, y, lines[i]->text, color);
+        y += 12;
+    }
 }
 
 static void draw_build_window(Window* win) {
@@ -150,28 +214,22 @@ static void draw_build_window(Window* win) {
         "[4] Demolish"
     };
     
-    draw_text_bitmap(g_framebuffer, win->x + 10, win->y + 30, "Build Tools", 0x000000, SCREEN_WIDTH);
+    draw_text_bitmap(&g_target, win->x + 10, win->y + 30, "Build Tools", 0x000000);
     
     for (int i = 0; i < 4; i++) {
         uint32_t color = (g_current_tool == i + 1) ? 0xFF0000 : 0x000000;
-        draw_text_bitmap(g_framebuffer, win->x + 10, win->y + 50 + i * 15, tools[i], color, SCREEN_WIDTH);
+        draw_text_bitmap(&g_target, win->x + 10, win->y + 50 + i * 15, tools[i], color);
     }
     
     // Show current tool
-    const char* tool_names[] = {"None", "Raise", "Lower", "Path", "Demolish"};
-    char buffer[64];
-    snprintf(buffer, sizeof(buffer), "Active: %s", tool_names[g_current_tool]);
-    draw_text_bitmap(g_framebuffer, win->x + 10, win->y + 120, buffer, 0x0000AA, SCREEN_WIDTH);
+    draw_text_bitmap(&g_target, win->x + 10, win->y + 120, g_tool_text.text, 0x0000AA);
 }
 
 static void draw_rides_window(Window* win) {
-    draw_text_bitmap(g_framebuffer, win->x + 10, win->y + 30, "Rides", 0x000000, SCREEN_WIDTH);
+    draw_text_bitmap(&g_target, win->x + 10, win->y + 30, "Rides", 0x000000);
     
-    int num_rides = get_num_rides();
-    for (int i = 0; i < num_rides && i < 5; i++) {
-        char buffer[64];
-        snprintf(buffer, sizeof(buffer), "%s: %d", get_ride_name(i), get_ride_queue(i));
-        draw_text_bitmap(g_framebuffer, win->x + 10, win->y + 50 + i * 12, buffer, 0x000000, SCREEN_WIDTH);
+    for (int i = 0; i < g_values.rides.value && i < MAX_RIDE_ROWS; i++) {
+        draw_text_bitmap(&g_target, win->x + 10, win->y + 50 + i * 12, g_ride_rows[i].text, 0x000000);
     }
 }
 
@@ -204,44 +262,124 @@ void init_ui(void) {
     strcpy(g_windows[2].title, "Rides");
 }
 
+static void draw_window(Window* win) {
+    draw_window_frame(win);
+    
+    switch (win->type) {
+        case WINDOW_STATS:
+            draw_stats_window(win);
+            break;
+        case WINDOW_BUILD:
+            draw_build_window(win);
+            break;
+        case WINDOW_RIDES:
+            draw_rides_window(win);
+            break;
+        default:
+            break;
+    }
+}
+
+// Sum of the generations of everything a window shows
+static uint32_t get_window_generation(const Window* win) {
+    uint32_t generation = 0;
+    
+    switch (win->type) {
+        case WINDOW_STATS:
+            generation = g_time_text.seen_generation + g_weather_text.seen_generation +
+                         g_guests_text.seen_generation + g_total_text.seen_generation +
+                         g_rating_text.seen_generation + g_money_text.seen_generation +
+                         g_staff_text.seen_generation + g_rides_text.seen_generation;
+            break;
+        case WINDOW_BUILD:
+            generation = g_tool_text.seen_generation;
+            break;
+        case WINDOW_RIDES:
+            // Every row, shown or not, so the sum never goes backwards
+            generation = g_rides_text.seen_generation;
+            for (int i = 0; i < MAX_RIDE_ROWS; i++) {
+                generation += g_ride_rows[i].seen_generation;
+            }
+            break;
+        default:
+            break;
+    }
+    
+    return generation;
+}
+
+// Redraw a window into its own surface if what it shows has changed
+static bool refresh_window_surface(Window* win) {
+    uint32_t generation = get_window_generation(win);
+    if (win->surface.pixels && win->surface_valid && win->content_generation == generation) {
+        return true;
+    }
+    
+    if (!win->surface.pixels) {
+        win->surface.pixels = (uint8_t*)malloc((size_t)win->width * win->height * 4);
+        if (!win->surface.pixels) {
+            printf("Failed to allocate window surface: %s\n", win->title);
+            return false;
+        }
+        win->surface.width = win->width;
+        win->surface.height = win->height;
+        win->surface.pitch = win->width * 4;
+    }
+    
+    // Draw at the surface origin
+    Window local = *win;
+    local.x = 0;
+    local.y = 0;
+    
+    g_target = win->surface;
+    draw_window(&local);
+    
+    win->content_generation = generation;
+    win->surface_valid = true;
+    return true;
+}
+
+// Copy a cached window surface onto the screen
+static void blit_window_surface(const Window* win) {
+    int x0 = win->x < 0 ? 0 : win->x;
+    int y0 = win->y < 0 ? 0 : win->y;
+    int x1 = win->x + win->width > g_screen.width ? g_screen.width : win->x + win->width;
+    int y1 = win->y + win->height > g_screen.height ? g_screen.height : win->y + win->height;
+    if (x0 >= x1 || y0 >= y1) return;
+    
+    size_t row_bytes = (size_t)(x1 - x0) * 4;
+    for (int y = y0; y < y1; y++) {
+        const uint8_t* src = render_target_pixel(&win->surface, x0 - win->x, y - win->y);
+        memcpy(render_target_pixel(&g_screen, x0, y), src, row_bytes);
+    }
+}
+
 void render_ui(void) {
-    if (!g_framebuffer) {
+    if (!g_screen.pixels) {
         return;
     }
     
+    update_ui_values();
+    update_ui_bindings();
+    
     for (int i = 0; i < MAX_WINDOWS; i++) {
         if (!g_windows[i].active) continue;
         
-        draw_window_frame(&g_windows[i]);
-        
-        switch (g_windows[i].type) {
-            case WINDOW_STATS:
-                draw_stats_window(&g_windows[i]);
-                break;
-            case WINDOW_BUILD:
-                draw_build_window(&g_windows[i]);
-                break;
-            case WINDOW_RIDES:
-                draw_rides_window(&g_windows[i]);
-                break;
-            default:
-                break;
+        if (refresh_window_surface(&g_windows[i])) {
+            blit_window_surface(&g_windows[i]);
+            continue;
         }
+        
+        // No surface: draw straight to the screen
+        g_target = g_screen;
+        draw_window(&g_windows[i]);
     }
 }
 
-void handle_mouse_click(int x, int y, int button) {
-    if (button != 1) return;
-    
-    // Convert screen to isometric coordinates
-    int iso_x, iso_y;
-    screen_to_iso(x, y, &iso_x, &iso_y);
-    
-    printf("Click at screen(%d, %d) -> iso(%d, %d), tool=%d\n", 
-           x, y, iso_x, iso_y, g_current_tool);
-    
-    // Apply current tool
-    switch (g_current_tool) {
+// Apply a tool at a tile (caller holds the simulation lock). Shared by the
+// mouse and by command replay.
+void apply_tool(int tool, int iso_x, int iso_y) {
+    switch ((ToolType)tool) {
         case TOOL_RAISE:
             set_tile_height(iso_x, iso_y, 1);
             set_tile_height(iso_x + 1, iso_y, 1);
@@ -265,7 +403,33 @@ void handle_mouse_click(int x, int y, int button) {
     }
 }
 
+void select_tool(int tool) {
+    g_current_tool = (ToolType)tool;
+}
+
+void handle_mouse_click(int x, int y, int button) {
+    if (button != 1) return;
+    
+    // Convert screen to isometric coordinates
+    int iso_x, iso_y;
+    screen_to_iso(x, y, &iso_x, &iso_y);
+    
+    printf("Click at screen(%d, %d) -> iso(%d, %d), tool=%d\n", 
+           x, y, iso_x, iso_y, g_current_tool);
+    
+    // Apply current tool between simulation ticks, journaled against the
+    // tick it lands before
+    lock_simulation();
+    apply_tool(g_current_tool, iso_x, iso_y);
+    if (g_current_tool != TOOL_NONE) {
+        record_command(COMMAND_APPLY_TOOL, g_current_tool, iso_x, iso_y);
+    }
+    unlock_simulation();
+}
+
 void handle_key_press(int key) {
+    ToolType previous = g_current_tool;
+
     switch (key) {
         case SDLK_1:
             g_current_tool = TOOL_RAISE;
@@ -288,8 +452,12 @@ void handle_key_press(int key) {
             printf("Tool: None\n");
             break;
     }
+
+    if (g_current_tool != previous) {
+        record_command(COMMAND_SELECT_TOOL, g_current_tool, 0, 0);
+    }
 }
 
-void set_ui_framebuffer(uint8_t* fb) {
-    g_framebuffer = fb;
+void set_ui_target(const RenderTarget* target) {
+    g_screen = *target;
 }
\ No newline at end of file